@@ -2,7 +2,8 @@
 * @file alerts.h
 * @brief Alert definitions
 *
-* This library provides an Alert struct to create alert types.
+* This library provides an Alert struct to create alert types, and a Sequence struct to
+* create alerts made of several tones in a row (e.g. doorbells).
 * 
 * @author Nahum Manuel Martín
 * @date 2023/06/25
@@ -19,10 +20,14 @@
  */
 struct AlertElement {
   // Fixed data
-  unsigned short freq; /**< Frequency in Hz. Fixed information. */
+  unsigned short freq; /**< Frequency in Hz. Fixed information, matched if pitchTolerance > 0. */
   int minIntensity; /**< Minimum intensity. Fixed parameter. */
   int iteratorRangeMin; /**< Minimum value of Iterator range. Fixed parameter. */
   int iteratorRangeMax; /**< Maximum value of Iterator range. Fixed parameter. */
+  float maxFlatness; /**< Maximum spectral flatness (see spectralFeatures.h), 1 for any sound. Fixed parameter. */
+  float pitchTolerance; /**< Max. Hz between the pitch (see pitchDetector.h) and freq, 0 to match the peak bin instead. Fixed parameter. */
+  bool averaged; /**< True to match the peak of the averaged power spectrum (see psdAverage.h) instead of the frame peak. Fixed parameter. */
+  int minAverageIntensity; /**< Minimum magnitude of the averaged peak (square root of its mean power), used instead of minIntensity if averaged. Fixed parameter. */
 
   // Additional information
   int intensityMark; /**< Intensity mark. */
@@ -40,10 +45,60 @@ struct AlertElement {
   bool alertStatus; /**< Alert status. */
 };
 
+/**
+ * @brief Struct representing one tone of a sequence.
+ */
+struct ToneStep {
+  unsigned short freq; /**< Frequency in Hz. Fixed information, matched if pitchTolerance > 0. */
+  int minIntensity; /**< Minimum intensity. Fixed parameter. */
+  int iteratorRangeMin; /**< Minimum value of Iterator range. Fixed parameter. */
+  int iteratorRangeMax; /**< Maximum value of Iterator range. Fixed parameter. */
+  float maxFlatness; /**< Maximum spectral flatness (see spectralFeatures.h), 1 for any sound. Fixed parameter. */
+  float pitchTolerance; /**< Max. Hz between the pitch (see pitchDetector.h) and freq, 0 to match the peak bin instead. Fixed parameter. */
+  bool averaged; /**< True to match the peak of the averaged power spectrum (see psdAverage.h) instead of the frame peak. Fixed parameter. */
+  int minAverageIntensity; /**< Minimum magnitude of the averaged peak (square root of its mean power), used instead of minIntensity if averaged. Fixed parameter. */
+};
+
 // ---------- Constants --------------
 const unsigned char N_ALERT_TYPES = 2;
 static AlertElement alerts[N_ALERT_TYPES];
 
+const unsigned char MAX_SEQUENCE_STEPS = 4; /**< Maximum number of tones of a sequence. */
+
+/**
+ * @brief Struct representing a sequence alert: ordered tones with a timing tolerance.
+ *
+ * The sequence is recognized by a small automaton fed with the peak of each frame.
+ */
+struct SequenceElement {
+  // Fixed data
+  ToneStep steps[MAX_SEQUENCE_STEPS]; /**< Tones in order. Fixed parameter. */
+  unsigned char nSteps; /**< Number of tones. Fixed parameter. */
+  unsigned short maxGap; /**< Max. ms between the last frame of a tone and the first of the next one. Fixed parameter. */
+
+  // Automaton state
+  unsigned char step; /**< Number of tones already recognized. */
+  unsigned long lastSeen; /**< Time (ms) of the last frame of the current tone. */
+
+  // Additional information
+  int intensityMark; /**< Intensity mark of the last tone. */
+
+  // Image 1 properties
+  short image1_xPos; /**< X position of image 1. */
+  short image1_yPos; /**< Y position of image 1. */
+  const Xbm *image1; /**< Pointer to image 1. */
+
+  // Image 2 properties
+  short image2_xPos; /**< X position of image 2. */
+  short image2_yPos; /**< Y position of image 2. */
+  const Xbm *image2; /**< Pointer to image 2. */
+
+  bool alertStatus; /**< Alert status. */
+};
+
+const unsigned char N_SEQUENCE_TYPES = 1;
+static SequenceElement sequences[N_SEQUENCE_TYPES];
+
 // ---------- Function Prototypes --------------
 /**
  * @brief Initializes the alerts.
@@ -57,6 +112,10 @@ void initAlerts() {
   alerts[0].iteratorRangeMin = 92;
   alerts[0].iteratorRangeMax = 93;
   alerts[0].minIntensity = 40000;
+  alerts[0].maxFlatness = 1;
+  alerts[0].pitchTolerance = 0;
+  alerts[0].averaged = false;
+  alerts[0].minAverageIntensity = 40000;
   alerts[0].freq = 1400; // additional info, no compute
   alerts[0].image1_xPos = (DISPLAY_WIDTH / 3) - (arrow_left_img.getWidth() / 2);
   alerts[0].image1_yPos = (DISPLAY_HEIGHT - arrow_left_img.getHeight()) / 2;
@@ -70,6 +129,10 @@ void initAlerts() {
   alerts[1].iteratorRangeMin = 85;
   alerts[1].iteratorRangeMax = 86;
   alerts[1].minIntensity = 20000;
+  alerts[1].maxFlatness = 1;
+  alerts[1].pitchTolerance = 0;
+  alerts[1].averaged = false;
+  alerts[1].minAverageIntensity = 20000;
   alerts[1].freq = 1300; // additional info, no compute
   alerts[1].image1_xPos = (DISPLAY_WIDTH / 3) - (arrow_down_img.getWidth() / 2);
   alerts[1].image1_yPos = (DISPLAY_HEIGHT - arrow_down_img.getHeight()) / 2;
@@ -77,4 +140,32 @@ void initAlerts() {
   alerts[1].image2_xPos = ((DISPLAY_WIDTH / 3) * 2)  - (phone_img.getWidth() / 2);
   alerts[1].image2_yPos = (DISPLAY_HEIGHT - phone_img.getHeight()) / 2;
   alerts[1].image2 = &phone_img;
+
+  // Initialize sequence 1: doorbell, 1300 Hz then 1400 Hz within 500 ms.
+  sequences[0].alertStatus = false;
+  sequences[0].step = 0;
+  sequences[0].nSteps = 2;
+  sequences[0].maxGap = 500;
+  sequences[0].steps[0].iteratorRangeMin = 85;
+  sequences[0].steps[0].iteratorRangeMax = 86;
+  sequences[0].steps[0].minIntensity = 20000;
+  sequences[0].steps[0].maxFlatness = 1;
+  sequences[0].steps[0].pitchTolerance = 0;
+  sequences[0].steps[0].averaged = false;
+  sequences[0].steps[0].minAverageIntensity = 20000;
+  sequences[0].steps[0].freq = 1300; // additional info, no compute
+  sequences[0].steps[1].iteratorRangeMin = 92;
+  sequences[0].steps[1].iteratorRangeMax = 93;
+  sequences[0].steps[1].minIntensity = 20000;
+  sequences[0].steps[1].maxFlatness = 1;
+  sequences[0].steps[1].pitchTolerance = 0;
+  sequences[0].steps[1].averaged = false;
+  sequences[0].steps[1].minAverageIntensity = 20000;
+  sequences[0].steps[1].freq = 1400; // additional info, no compute
+  sequences[0].image1_xPos = (DISPLAY_WIDTH / 3) - (arrow_left_img.getWidth() / 2);
+  sequences[0].image1_yPos = (DISPLAY_HEIGHT - arrow_left_img.getHeight()) / 2;
+  sequences[0].image1 = &arrow_left_img;
+  sequences[0].image2_xPos = ((DISPLAY_WIDTH / 3) * 2)  - (bell_img.getWidth() / 2);
+  sequences[0].image2_yPos = (DISPLAY_HEIGHT - bell_img.getHeight()) / 2;
+  sequences[0].image2 = &bell_img;
 }
@@ -0,0 +1,132 @@
+/**
+ * @file buttonInput.h
+ * @brief Interrupt driven input of the P button
+ *
+ * This file contains the input of the P button. An interrupt on both edges debounces them
+ * and latches them as events in a queue, so a press is never missed while the loop
+ * captures or draws and nothing waits for the bounces. A release (the end of a click)
+ * also cancels the analysis in progress (see cancelToken.h), so the mode change is seen
+ * within a capture instead of after the whole frame.
+ *
+ * The loop takes the events with nextButtonEvent(). It also checks the level, which
+ * recovers an edge the debounce has rejected (a tap shorter than BUTTON_DEBOUNCE_MS).
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include "board.h"
+#include "cancelToken.h"
+
+// ---------- Constants --------------
+/**
+ * @brief Time an edge must last to be accepted (ms).
+ */
+const unsigned long BUTTON_DEBOUNCE_MS = 30;
+
+/**
+ * @brief Events of the queue, a power of 2.
+ */
+const unsigned char BUTTON_QUEUE_SIZE = 8;
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Types of button event.
+ */
+typedef enum {
+  BUTTON_PRESS,   ///< The button went down.
+  BUTTON_RELEASE, ///< The button went up, the end of a click.
+} ButtonEventType;
+
+/**
+ * @brief Debounced edge of the button.
+ */
+struct ButtonEvent {
+  ButtonEventType type; /**< Edge. */
+  unsigned long time; /**< Time of the edge (ms). */
+};
+
+/**
+ * @namespace buttonInput
+ * @brief Namespace for the queue of button events. The interrupt writes head, the loop tail.
+ */
+namespace buttonInput {
+  volatile ButtonEvent queue[BUTTON_QUEUE_SIZE]; /**< Ring of events. */
+  volatile unsigned char head = 0; /**< Next event to write. */
+  volatile unsigned char tail = 0; /**< Next event to read. */
+  volatile int level = HIGH; /**< Debounced level, HIGH is released. */
+  volatile unsigned long lastEdge = 0; /**< Time of the last accepted edge (ms). */
+  volatile unsigned long dropped = 0; /**< Events lost with the queue full. */
+}
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Reads the current level and attaches the interrupt of the button.
+ */
+void initButton();
+
+/**
+ * @brief Takes the next button event.
+ * @param event Output: the event.
+ * @return False if there are no events.
+ */
+bool nextButtonEvent(ButtonEvent &event);
+
+/**
+ * @brief Queues a debounced edge and cancels the analysis on a release.
+ * @param level The new level.
+ * @param now Time of the edge (ms).
+ */
+void IRAM_ATTR latchButtonEdge(int level, unsigned long now);
+
+/**
+ * @brief Interrupt of the button, on both edges.
+ */
+void IRAM_ATTR buttonInterrupt();
+
+// ---------- Code --------------
+void initButton() {
+  pinMode(BUTTON_P_PIN, INPUT_PULLUP);
+  buttonInput::level = digitalRead(BUTTON_P_PIN);
+  buttonInput::lastEdge = millis();
+  attachInterrupt(digitalPinToInterrupt(BUTTON_P_PIN), buttonInterrupt, CHANGE);
+}
+
+void IRAM_ATTR latchButtonEdge(int level, unsigned long now) {
+  buttonInput::level = level;
+  buttonInput::lastEdge = now;
+  unsigned char next = (buttonInput::head + 1) & (BUTTON_QUEUE_SIZE - 1);
+  if (next == buttonInput::tail) {
+    buttonInput::dropped++;
+    return;
+  }
+  buttonInput::queue[buttonInput::head].type = level == LOW ? BUTTON_PRESS : BUTTON_RELEASE;
+  buttonInput::queue[buttonInput::head].time = now;
+  buttonInput::head = next;
+  if (level == HIGH) analysisCancel.cancel();
+}
+
+void IRAM_ATTR buttonInterrupt() {
+  int level = digitalRead(BUTTON_P_PIN);
+  unsigned long now = millis();
+  if (level == buttonInput::level or now - buttonInput::lastEdge < BUTTON_DEBOUNCE_MS) return;
+  latchButtonEdge(level, now);
+}
+
+bool nextButtonEvent(ButtonEvent &event) {
+  // An edge inside the debounce time of the previous one was rejected, take it if it lasted.
+  noInterrupts();
+  int level = digitalRead(BUTTON_P_PIN);
+  unsigned long now = millis();
+  if (level != buttonInput::level and now - buttonInput::lastEdge >= BUTTON_DEBOUNCE_MS) latchButtonEdge(level, now);
+  interrupts();
+
+  if (buttonInput::tail == buttonInput::head) return false;
+  event.type = buttonInput::queue[buttonInput::tail].type;
+  event.time = buttonInput::queue[buttonInput::tail].time;
+  buttonInput::tail = (buttonInput::tail + 1) & (BUTTON_QUEUE_SIZE - 1);
+  return true;
+}
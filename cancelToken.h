@@ -0,0 +1,47 @@
+/**
+ * @file cancelToken.h
+ * @brief Cancellation of the long analysis
+ *
+ * This file contains the token the long analysis checks to stop early: the capture of the
+ * spectrum bus (64 ms) and the FFT columns of the 1 second spectrogram. The button
+ * interrupt cancels it on a click, so the next mode starts without waiting for the rest
+ * of the work of the current one. The check is a read of a flag.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Cancellation request, set from an interrupt and read by the loop.
+ */
+struct CancelToken {
+  volatile bool requested; /**< True once cancelled, until reset. */
+
+  /**
+   * @brief Requests the cancellation. Interrupt safe.
+   */
+  void cancel() {
+    requested = true;
+  }
+
+  /**
+   * @brief Clears the request before the next analysis.
+   */
+  void reset() {
+    requested = false;
+  }
+
+  /**
+   * @brief Tells if the analysis must stop.
+   * @return True if cancelled.
+   */
+  bool cancelled() const {
+    return requested;
+  }
+};
+
+// ---------- Globals --------------
+CancelToken analysisCancel = {false}; /**< Token of the analysis of the loop. */
@@ -0,0 +1,209 @@
+/**
+ * @file cycleTelemetry.h
+ * @brief Cycle counters of the hot path and binary telemetry
+ *
+ * This file contains the cycle counters of the hot path: acquisition, window, FFT, peak
+ * search, spectral features, pitch, averaged power spectrum, alert matching, the step of
+ * the tool mode and display(). Each stage is bracketed with CYCLE_BEGIN() and CYCLE_END(),
+ * which read the CPU cycle counter and add the count to a fixed log2 histogram (bucket b
+ * holds counts in [2^(b-1), 2^b)) with the count, min, max and sum.
+ *
+ * CYCLE_REPORT() sends the histograms as one SERIAL_FRAME_CYCLES frame (see serialFrame.h)
+ * and starts new ones; the sketch runs it every CYCLE_REPORT_MS as a scheduler task.
+ * tools/cycleTelemetryDecoder.cpp pretty-prints the frames from a capture of the Serial
+ * port.
+ *
+ * Define CYCLE_TELEMETRY to enable it (in the sketch, before the includes, or with
+ * -DCYCLE_TELEMETRY). Otherwise the macros expand to nothing: no code, no RAM.
+ *
+ * Payload of a frame, little endian:
+ *   sequence (2) | ticks per us (2) | period ms (4) | stages (1)
+ *   per stage: stage (1) | count (4) | min (4) | max (4) | sum (8) | first bucket (1) |
+ *              buckets (1) | count of each bucket (2 each)
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// ---------- Constants --------------
+/**
+ * @brief Stages of the hot path.
+ */
+typedef enum {
+  CYC_ACQUIRE,      ///< Sound capture
+  CYC_WINDOW,       ///< applyWindow()
+  CYC_FFT,          ///< performFFT()
+  CYC_PEAK,         ///< Peak search
+  CYC_MATCH,        ///< Alert and sequence matching
+  CYC_DISPLAY,      ///< display()
+  CYC_FEATURES,     ///< Spectral features, after CYC_PEAK (last to keep the stage ids of older captures)
+  CYC_PITCH,        ///< Pitch estimation, after CYC_FEATURES
+  CYC_PSD,          ///< Averaged power spectrum, after CYC_PITCH
+  CYC_MODE,         ///< Step of the tool mode, drawing in the framebuffer, after CYC_PSD
+  N_CYCLE_STAGES
+} CycleStage;
+
+/**
+ * @brief Names of the stages, in CycleStage order.
+ */
+const char *const CYCLE_STAGE_NAMES[N_CYCLE_STAGES] = {
+  "acquire", "window", "fft", "peak", "match", "display", "features", "pitch", "psd", "mode"
+};
+
+/**
+ * @brief Buckets of a histogram, enough for any 32 bit count.
+ */
+const unsigned char CYCLE_BUCKETS = 33;
+
+#ifdef CYCLE_TELEMETRY
+
+#include "Arduino.h"
+#include "serialFrame.h"
+#ifndef ESP_PLATFORM
+#include <chrono>
+#endif
+
+/**
+ * @brief Time between two telemetry frames (ms).
+ */
+const unsigned long CYCLE_REPORT_MS = 5000ul;
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Cycle histogram of a stage.
+ */
+struct CycleHistogram {
+  uint32_t count; /**< Measures. */
+  uint32_t minimum; /**< Fewest cycles, valid if count > 0. */
+  uint32_t maximum; /**< Most cycles. */
+  uint64_t sum; /**< Sum of the cycles. */
+  uint16_t buckets[CYCLE_BUCKETS]; /**< Measures of each log2 bucket, saturated. */
+
+  /**
+   * @brief Adds a measure.
+   * @param cycles Cycles of the stage.
+   */
+  void add(uint32_t cycles) {
+    unsigned char b = cycles == 0 ? 0 : 32 - __builtin_clz(cycles);
+    if (buckets[b] < UINT16_MAX) buckets[b]++;
+    if (count == 0 or cycles < minimum) minimum = cycles;
+    if (cycles > maximum) maximum = cycles;
+    sum += cycles;
+    count++;
+  }
+};
+
+/**
+ * @namespace cycleTelemetry
+ * @brief Namespace for the cycle counters.
+ */
+namespace cycleTelemetry {
+  CycleHistogram stages[N_CYCLE_STAGES]; /**< Histogram of each stage since the last report. */
+  uint32_t started[N_CYCLE_STAGES]; /**< Cycle counter at the start of each stage. */
+  uint16_t sequence = 0; /**< Number of the next frame. */
+  unsigned long lastReport = 0; /**< millis() of the last report. */
+}
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Reads the cycle counter.
+ * @return CPU cycles on the device, ns on the host. Wraps around.
+ */
+inline uint32_t cycleCount();
+
+/**
+ * @brief Gets the ticks of cycleCount() per microsecond.
+ * @return CPU frequency in MHz on the device, 1000 on the host.
+ */
+uint16_t cycleTicksPerUs();
+
+/**
+ * @brief Starts the measure of a stage.
+ * @param stage The stage.
+ */
+inline void cycleBegin(CycleStage stage);
+
+/**
+ * @brief Ends the measure of a stage and adds it to its histogram.
+ * @param stage The stage.
+ */
+inline void cycleEnd(CycleStage stage);
+
+/**
+ * @brief Sends the histograms since the last report and clears them.
+ * @param out Output stream, usually Serial.
+ */
+void cycleReport(Print &out);
+
+// ---------- Code --------------
+inline uint32_t cycleCount() {
+#ifdef ESP_PLATFORM
+  return ESP.getCycleCount();
+#else
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+uint16_t cycleTicksPerUs() {
+#ifdef ESP_PLATFORM
+  return getCpuFrequencyMhz();
+#else
+  return 1000;
+#endif
+}
+
+inline void cycleBegin(CycleStage stage) {
+  cycleTelemetry::started[stage] = cycleCount();
+}
+
+inline void cycleEnd(CycleStage stage) {
+  cycleTelemetry::stages[stage].add(cycleCount() - cycleTelemetry::started[stage]);
+}
+
+void cycleReport(Print &out) {
+  static uint8_t payload[9 + N_CYCLE_STAGES * (23 + CYCLE_BUCKETS * 2)];
+  unsigned long now = millis();
+  unsigned char used = 0;
+  for (unsigned char i = 0; i < N_CYCLE_STAGES; i++) used += cycleTelemetry::stages[i].count > 0;
+
+  PayloadWriter w = {payload, sizeof(payload), 0};
+  w.u16(cycleTelemetry::sequence++);
+  w.u16(cycleTicksPerUs());
+  w.u32(now - cycleTelemetry::lastReport);
+  w.u8(used);
+  for (unsigned char i = 0; i < N_CYCLE_STAGES; i++) {
+    const CycleHistogram &h = cycleTelemetry::stages[i];
+    if (h.count == 0) continue;
+    unsigned char first = 0, last = CYCLE_BUCKETS - 1;
+    while (h.buckets[first] == 0) first++;
+    while (h.buckets[last] == 0) last--;
+    w.u8(i);
+    w.u32(h.count);
+    w.u32(h.minimum);
+    w.u32(h.maximum);
+    w.u64(h.sum);
+    w.u8(first);
+    w.u8(last - first + 1);
+    for (unsigned char b = first; b <= last; b++) w.u16(h.buckets[b]);
+  }
+  writeSerialFrame(out, SERIAL_FRAME_CYCLES, payload, w.length);
+
+  memset(cycleTelemetry::stages, 0, sizeof(cycleTelemetry::stages));
+  cycleTelemetry::lastReport = now;
+}
+
+#define CYCLE_BEGIN(stage) cycleBegin(stage)
+#define CYCLE_END(stage) cycleEnd(stage)
+#define CYCLE_REPORT(out) cycleReport(out)
+
+#else
+
+#define CYCLE_BEGIN(stage) do {} while (0)
+#define CYCLE_END(stage) do {} while (0)
+#define CYCLE_REPORT(out) do {} while (0)
+
+#endif
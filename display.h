@@ -3,7 +3,9 @@
  * @brief This file contains the configuration for Adafruit display module.
  *
  * The display module handles the communication with the OLED display and provides
- * functions for initializing and interacting with the display.
+ * functions for initializing and interacting with the display. The modes draw on the
+ * `display` Renderer (renderer.h): the panel on the device, or an in-memory framebuffer
+ * if HEADLESS_DISPLAY is defined.
  *
  * @author Nahum Manuel Martín
  * @date 2023/06/25
@@ -34,11 +36,26 @@ const unsigned char OLED_RESET = 21;
  */
 const char SCREEN_ADDRESS = 0x3C;
 
+// Define HEADLESS_DISPLAY to draw in memory instead of on the panel (host builds).
+#ifdef HEADLESS_DISPLAY
+#include "framebufferRenderer.h"
+/**
+ * @brief Display object. In-memory framebuffer, see framebufferRenderer.h.
+ */
+FramebufferRenderer display(DISPLAY_WIDTH, DISPLAY_HEIGHT);
+#else
 #include <Adafruit_SSD1306.h>
+#include "partialDisplay.h"
+/**
+ * @brief Adafruit SSD1306 panel object. Sends only the changed areas on display().
+ */
+PartialSSD1306 panel(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire1, OLED_RESET);
+
 /**
- * @brief Adafruit SSD1306 display object.
+ * @brief Display object. Renderer of the panel.
  */
-Adafruit_SSD1306 display(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire1, OLED_RESET);
+SSD1306Renderer display(panel);
+#endif
 
 /**
  * @brief Font size 1 - Height in pixels.
@@ -56,14 +73,16 @@ const unsigned short FONT_WIDTH = 6;
  * @brief Initializes the display.
  */
 void initDisplay() {
+#ifndef HEADLESS_DISPLAY
   // Display communication Adafruit
   Wire1.begin(SDA_OLED, SCL_OLED);
 
   // SSD1306_SWITCHCAPVCC = generate display voltage from 3.3V internally
-  if(!display.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS)) {
+  if(!panel.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS)) {
     Serial.println(F("SSD1306 allocation failed"));
     for(;;); // Don't proceed, loop forever
   }
+#endif
 
   display.clearDisplay(); // Disable Adafruit logo
   display.display();
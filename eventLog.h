@@ -0,0 +1,542 @@
+/**
+ * @file eventLog.h
+ * @brief Detection event log
+ *
+ * This file contains an append-only log of detection events. Every time an alert fires,
+ * a fixed-size binary record (timestamp, alert id, peak bin, intensity and SNR) is queued
+ * in RAM and later written to a ring buffer in persistent storage, so the detections of a
+ * whole night can be audited afterwards.
+ *
+ * The storage is accessed through the EventLogStorage interface:
+ * - PartitionLogStorage: device backend, a raw flash data partition (ESP32 only).
+ * - FileLogStorage: host backend, a fixed size file emulating the flash partition, at
+ *   EVENT_LOG_HOST_PATH (a temporary directory, not the current one) unless the host tool
+ *   sets another path before initEventLog().
+ *
+ * Writes are batched (EVENT_LOG_BATCH records) to limit flash wear. On the device the
+ * batches are written by a low priority task on the other core, so appending an event
+ * from the listening loop never waits for the flash. The loop can still stall: while the
+ * flash is written or erased, the ESP32 turns off the flash cache of both cores, so code
+ * of the loop that is not in IRAM waits for it. A batch write stalls it briefly, but a
+ * sector erase (once every 256 records, 32 batches) takes tens of milliseconds and can
+ * drop samples of the capture in progress.
+ *
+ * Storage layout: the storage is split in sectors, each sector holds EventRecords back to
+ * back. Erased slots read as 0xFF. When the ring wraps, the oldest sector is erased before
+ * it is reused. The newest record is the one with the highest sequence number.
+ *
+ * The log can be dumped (e.g. `esptool.py read_flash <offset> <size> log.bin`) and converted
+ * to CSV with tools/eventLogDecoder.cpp.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+// ---------- Constants --------------
+#ifndef EVENT_LOG_HOST_PATH
+/**
+ * @brief Default file of the host backend. Can be defined at build time.
+ */
+#define EVENT_LOG_HOST_PATH "/tmp/soundAlert-eventlog.bin"
+#endif
+
+/**
+ * @brief Number of queued records that triggers a write to the storage.
+ */
+const unsigned char EVENT_LOG_BATCH = 8;
+
+/**
+ * @brief Capacity of the RAM queue. Events are dropped (and counted) if it is full.
+ */
+const unsigned char EVENT_LOG_QUEUE = 32;
+
+/**
+ * @brief Maximum time (ms) a queued record waits before it is written anyway.
+ */
+const unsigned long EVENT_LOG_MAX_DELAY = 60ul * 1000ul;
+
+/**
+ * @brief Sector size of the storage. Erase unit of the ESP32 flash.
+ */
+const uint32_t EVENT_LOG_SECTOR_SIZE = 4096;
+
+/**
+ * @brief Value of a sequence number in an erased slot.
+ */
+const uint32_t EVENT_LOG_EMPTY = 0xFFFFFFFFul;
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Binary record of one detection. 16 bytes, little endian.
+ */
+struct EventRecord {
+  uint32_t sequence;  /**< Monotonic record number. EVENT_LOG_EMPTY in erased slots. */
+  uint32_t timestamp; /**< Seconds of the RTC clock (kept during deep sleep). */
+  uint32_t intensity; /**< Intensity of the peak bin. */
+  uint16_t peakBin;   /**< Index of the peak bin. */
+  uint8_t alertId;    /**< Index of the fired alert. */
+  int8_t snr;         /**< Peak to mean spectrum ratio in dB. */
+};
+
+static_assert(sizeof(EventRecord) == 16, "EventRecord must be 16 bytes");
+static_assert(EVENT_LOG_SECTOR_SIZE % sizeof(EventRecord) == 0, "Records can't cross sectors");
+
+// ---------- Storage interface --------------
+/**
+ * @class EventLogStorage
+ * @brief Storage interface of the event log. Flash-like semantics: erased bytes read
+ * 0xFF and a sector must be erased before it is written again.
+ */
+class EventLogStorage {
+public:
+  virtual ~EventLogStorage() {}
+
+  /**
+   * @brief Opens the storage.
+   * @return True if the storage is ready.
+   */
+  virtual bool begin() = 0;
+
+  /**
+   * @brief Gets the usable size of the storage.
+   * @return Size in bytes, multiple of EVENT_LOG_SECTOR_SIZE.
+   */
+  virtual uint32_t size() const = 0;
+
+  /**
+   * @brief Reads bytes from the storage.
+   * @param offset Offset in bytes.
+   * @param dst Destination buffer.
+   * @param len Number of bytes.
+   * @return True on success.
+   */
+  virtual bool read(uint32_t offset, void *dst, uint32_t len) = 0;
+
+  /**
+   * @brief Writes bytes to an erased area of the storage.
+   * @param offset Offset in bytes.
+   * @param src Source buffer.
+   * @param len Number of bytes.
+   * @return True on success.
+   */
+  virtual bool write(uint32_t offset, const void *src, uint32_t len) = 0;
+
+  /**
+   * @brief Erases the sector that starts at the given offset.
+   * @param offset Offset in bytes, multiple of EVENT_LOG_SECTOR_SIZE.
+   * @return True on success.
+   */
+  virtual bool eraseSector(uint32_t offset) = 0;
+};
+
+#ifdef ESP_PLATFORM
+/**
+ * @class PartitionLogStorage
+ * @brief Device backend. Uses a raw data partition of the flash.
+ *
+ * The partition is searched by label. If the partition table has no such label, the
+ * SPIFFS data partition of the default tables is used, the sketch doesn't use SPIFFS.
+ */
+class PartitionLogStorage : public EventLogStorage {
+private:
+  const char *label; /**< Label of the partition. */
+  const esp_partition_t *partition; /**< Partition found by begin(). */
+
+public:
+  /**
+   * @brief Constructs the backend.
+   * @param l Label of the partition.
+   */
+  PartitionLogStorage(const char *l) : label(l), partition(nullptr) {}
+
+  bool begin() override {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (partition == nullptr) {
+      partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, nullptr);
+    }
+    return partition != nullptr and size() > 0;
+  }
+
+  uint32_t size() const override {
+    if (partition == nullptr) return 0;
+    return partition->size - (partition->size % EVENT_LOG_SECTOR_SIZE);
+  }
+
+  bool read(uint32_t offset, void *dst, uint32_t len) override {
+    return esp_partition_read(partition, offset, dst, len) == ESP_OK;
+  }
+
+  bool write(uint32_t offset, const void *src, uint32_t len) override {
+    return esp_partition_write(partition, offset, src, len) == ESP_OK;
+  }
+
+  bool eraseSector(uint32_t offset) override {
+    return esp_partition_erase_range(partition, offset, EVENT_LOG_SECTOR_SIZE) == ESP_OK;
+  }
+};
+#endif
+
+/**
+ * @class FileLogStorage
+ * @brief Host backend. A file of fixed size that emulates the flash partition.
+ */
+class FileLogStorage : public EventLogStorage {
+private:
+  const char *path; /**< Path of the file. */
+  uint32_t bytes; /**< Size of the emulated partition. */
+  FILE *file; /**< Open file. */
+
+public:
+  /**
+   * @brief Constructs the backend.
+   * @param p Path of the file. It is created (erased) if it doesn't exist.
+   * @param s Size in bytes, rounded down to sectors.
+   */
+  FileLogStorage(const char *p, uint32_t s)
+    : path(p), bytes(s - (s % EVENT_LOG_SECTOR_SIZE)), file(nullptr) {}
+
+  ~FileLogStorage() {
+    if (file != nullptr) fclose(file);
+  }
+
+  /**
+   * @brief Sets the path of the file. Must be called before begin().
+   * @param p Path of the file.
+   */
+  void setPath(const char *p) {
+    path = p;
+  }
+
+  bool begin() override {
+    file = fopen(path, "r+b");
+    if (file == nullptr) {
+      file = fopen(path, "w+b");
+      if (file == nullptr) return false;
+      for (uint32_t offset = 0; offset < bytes; offset += EVENT_LOG_SECTOR_SIZE) eraseSector(offset);
+    }
+    return true;
+  }
+
+  uint32_t size() const override {
+    return bytes;
+  }
+
+  bool read(uint32_t offset, void *dst, uint32_t len) override {
+    if (fseek(file, offset, SEEK_SET) != 0) return false;
+    return fread(dst, 1, len, file) == len;
+  }
+
+  bool write(uint32_t offset, const void *src, uint32_t len) override {
+    if (fseek(file, offset, SEEK_SET) != 0) return false;
+    bool ok = fwrite(src, 1, len, file) == len;
+    return fflush(file) == 0 and ok;
+  }
+
+  bool eraseSector(uint32_t offset) override {
+    unsigned char erased[256];
+    memset(erased, 0xFF, sizeof(erased));
+    if (fseek(file, offset, SEEK_SET) != 0) return false;
+    for (uint32_t i = 0; i < EVENT_LOG_SECTOR_SIZE; i += sizeof(erased)) {
+      if (fwrite(erased, 1, sizeof(erased), file) != sizeof(erased)) return false;
+    }
+    return fflush(file) == 0;
+  }
+};
+
+// ---------- Event log --------------
+/**
+ * @class EventLog
+ * @brief Ring buffer of EventRecords over an EventLogStorage.
+ *
+ * append() is called by the listening loop, flush() by the writer (the background task on
+ * the device). The RAM queue is single producer / single consumer, so no lock is needed.
+ */
+class EventLog {
+private:
+  EventLogStorage *storage; /**< Storage backend, nullptr if disabled. */
+  uint32_t head; /**< Offset of the next slot to write. */
+  uint32_t nextSequence; /**< Sequence of the next record. */
+  EventRecord queue[EVENT_LOG_QUEUE]; /**< Records waiting to be written. */
+  volatile unsigned char queueHead; /**< Next queue slot to fill (producer). */
+  volatile unsigned char queueTail; /**< Next queue slot to write (consumer). */
+  volatile unsigned long oldestQueued; /**< millis() of the first record of the batch. */
+  volatile unsigned long dropped; /**< Events lost because the queue was full. */
+
+  /**
+   * @brief Reads the sequence number of a slot.
+   * @param offset Offset of the slot.
+   * @return The sequence, EVENT_LOG_EMPTY if the slot is erased or unreadable.
+   */
+  uint32_t readSequence(uint32_t offset) {
+    uint32_t sequence = EVENT_LOG_EMPTY;
+    if (!storage->read(offset, &sequence, sizeof(sequence))) return EVENT_LOG_EMPTY;
+    return sequence;
+  }
+
+  /**
+   * @brief Finds the newest record and places head after it.
+   *
+   * @details Sectors are filled in order, so only the first slot of each sector is read
+   * to find the newest sector, and then only that sector is scanned.
+   */
+  void recover() {
+    uint32_t newestSector = 0;
+    uint32_t newestSequence = EVENT_LOG_EMPTY;
+    for (uint32_t offset = 0; offset < storage->size(); offset += EVENT_LOG_SECTOR_SIZE) {
+      uint32_t sequence = readSequence(offset);
+      if (sequence != EVENT_LOG_EMPTY and (newestSequence == EVENT_LOG_EMPTY or sequence > newestSequence)) {
+        newestSequence = sequence;
+        newestSector = offset;
+      }
+    }
+
+    head = 0;
+    nextSequence = 0;
+    if (newestSequence == EVENT_LOG_EMPTY) return;
+
+    head = newestSector;
+    for (uint32_t offset = newestSector; offset < newestSector + EVENT_LOG_SECTOR_SIZE; offset += sizeof(EventRecord)) {
+      uint32_t sequence = readSequence(offset);
+      if (sequence == EVENT_LOG_EMPTY) break;
+      nextSequence = sequence + 1;
+      head = offset + sizeof(EventRecord);
+    }
+    if (head >= storage->size()) head = 0;
+  }
+
+public:
+  /**
+   * @brief Constructs a disabled log.
+   */
+  EventLog()
+    : storage(nullptr), head(0), nextSequence(0), queueHead(0), queueTail(0), oldestQueued(0), dropped(0) {}
+
+  /**
+   * @brief Opens the storage and recovers the write position.
+   * @param s Storage backend.
+   * @return True if the log is enabled.
+   */
+  bool begin(EventLogStorage &s) {
+    storage = nullptr;
+    if (!s.begin() or s.size() < EVENT_LOG_SECTOR_SIZE * 2) return false;
+    storage = &s;
+    recover();
+    return true;
+  }
+
+  /**
+   * @brief Queues a record. Never waits for the storage.
+   * @param alertId Index of the fired alert.
+   * @param peakBin Index of the peak bin.
+   * @param intensity Intensity of the peak bin.
+   * @param snr Peak to mean spectrum ratio in dB.
+   * @param now Current millis(), used for the batch timeout.
+   * @return False if the record was dropped.
+   */
+  bool append(unsigned char alertId, unsigned short peakBin, unsigned long intensity, int snr, unsigned long now) {
+    if (storage == nullptr) return false;
+    unsigned char next = (queueHead + 1) % EVENT_LOG_QUEUE;
+    if (next == queueTail) {
+      dropped = dropped + 1;
+      return false;
+    }
+
+    EventRecord &r = queue[queueHead];
+    r.sequence = 0; // assigned by flush()
+    r.timestamp = (uint32_t)time(nullptr);
+    r.intensity = intensity;
+    r.peakBin = peakBin;
+    r.alertId = alertId;
+    r.snr = (int8_t)(snr > 127 ? 127 : (snr < -128 ? -128 : snr));
+    if (queueHead == queueTail) oldestQueued = now;
+    __sync_synchronize(); // Publish the record before the index.
+    queueHead = next;
+    return true;
+  }
+
+  /**
+   * @brief Gets the number of queued records.
+   * @return Records waiting to be written.
+   */
+  unsigned char pending() const {
+    return (queueHead + EVENT_LOG_QUEUE - queueTail) % EVENT_LOG_QUEUE;
+  }
+
+  /**
+   * @brief Checks if a batch must be written.
+   * @param now Current millis().
+   * @return True if the batch is full or its oldest record waited too long.
+   */
+  bool batchReady(unsigned long now) const {
+    unsigned char n = pending();
+    return n >= EVENT_LOG_BATCH or (n > 0 and now - oldestQueued >= EVENT_LOG_MAX_DELAY);
+  }
+
+  /**
+   * @brief Writes the queued records to the storage.
+   *
+   * @details Consecutive records are written with one storage call per sector. A sector
+   * is erased when the head enters it, which drops the oldest records of the ring.
+   *
+   * @return Number of records written.
+   */
+  unsigned char flush() {
+    if (storage == nullptr) return 0;
+    static EventRecord run[EVENT_LOG_QUEUE];
+    unsigned char written = 0;
+
+    while (queueTail != queueHead) {
+      if (head % EVENT_LOG_SECTOR_SIZE == 0 and !storage->eraseSector(head)) return written;
+
+      // Collect the records that fit in the current sector.
+      uint32_t room = (EVENT_LOG_SECTOR_SIZE - (head % EVENT_LOG_SECTOR_SIZE)) / sizeof(EventRecord);
+      unsigned char n = 0;
+      unsigned char tail = queueTail;
+      while (tail != queueHead and n < room) {
+        run[n] = queue[tail];
+        run[n].sequence = nextSequence + n;
+        tail = (tail + 1) % EVENT_LOG_QUEUE;
+        n++;
+      }
+
+      if (!storage->write(head, run, n * sizeof(EventRecord))) return written;
+      __sync_synchronize(); // Release the slots after they are copied.
+      queueTail = tail;
+      nextSequence += n;
+      head += n * sizeof(EventRecord);
+      if (head >= storage->size()) head = 0;
+      written += n;
+    }
+    return written;
+  }
+
+  /**
+   * @brief Gets the number of dropped events.
+   * @return Events lost because the queue was full.
+   */
+  unsigned long droppedEvents() const {
+    return dropped;
+  }
+
+  /**
+   * @brief Checks if the log has a storage.
+   * @return True if the log is enabled.
+   */
+  bool enabled() const {
+    return storage != nullptr;
+  }
+};
+
+// Host tools (tools/eventLogDecoder.cpp) only need the format above.
+#ifndef EVENT_LOG_FORMAT_ONLY
+
+#include "Arduino.h"
+
+// ---------- Globals --------------
+#ifdef ESP_PLATFORM
+PartitionLogStorage eventLogStorage("eventlog"); /**< Device storage of the log. */
+TaskHandle_t eventLogTaskHandle = nullptr; /**< Background writer task. */
+volatile bool eventLogFlushRequest = false; /**< Writes the queue even if the batch is not full. */
+#else
+FileLogStorage eventLogStorage(EVENT_LOG_HOST_PATH, 64ul * 1024ul); /**< Host storage of the log. */
+#endif
+EventLog eventLog; /**< Detection event log. */
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Initializes the event log and starts the background writer on the device.
+ */
+void initEventLog();
+
+/**
+ * @brief Logs a detection. Called from the listening loop, never blocks.
+ * @param alertId Index of the fired alert.
+ * @param peakBin Index of the peak bin.
+ * @param intensity Intensity of the peak bin.
+ * @param snr Peak to mean spectrum ratio in dB.
+ */
+void logDetection(unsigned char alertId, unsigned short peakBin, float intensity, int snr);
+
+/**
+ * @brief Writes the queued records if a batch is ready.
+ *
+ * @details On the device the writer task does it; on the host it must be called from
+ * the main loop.
+ */
+void serviceEventLog();
+
+/**
+ * @brief Writes every queued record. Must be called before deep sleep, RAM is lost.
+ */
+void flushEventLog();
+
+// ---------- Code --------------
+#ifdef ESP_PLATFORM
+/**
+ * @brief Background writer task. Wakes up on a full batch or once per second.
+ * @param arg Unused.
+ */
+void eventLogTask(void *arg) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+    if (eventLogFlushRequest or eventLog.batchReady(millis())) {
+      eventLog.flush();
+      eventLogFlushRequest = false;
+    }
+  }
+}
+#endif
+
+void initEventLog() {
+  if (!eventLog.begin(eventLogStorage)) {
+    Serial.println(F("Event log disabled: no storage"));
+    return;
+  }
+#ifdef ESP_PLATFORM
+  // Core 0: the Arduino loop (sampling) runs on core 1.
+  xTaskCreatePinnedToCore(eventLogTask, "eventLog", 3072, nullptr, 1, &eventLogTaskHandle, 0);
+#endif
+}
+
+void logDetection(unsigned char alertId, unsigned short peakBin, float intensity, int snr) {
+  unsigned long now = millis();
+  if (!eventLog.append(alertId, peakBin, intensity > 0 ? (unsigned long)intensity : 0ul, snr, now)) return;
+#ifdef ESP_PLATFORM
+  if (eventLogTaskHandle != nullptr and eventLog.pending() >= EVENT_LOG_BATCH) xTaskNotifyGive(eventLogTaskHandle);
+#endif
+}
+
+void serviceEventLog() {
+#ifndef ESP_PLATFORM
+  if (eventLog.batchReady(millis())) eventLog.flush();
+#endif
+}
+
+void flushEventLog() {
+#ifdef ESP_PLATFORM
+  // Let the writer task empty the queue, a second writer would race with it.
+  for (unsigned char i = 0; i < 50 and eventLog.pending() > 0; i++) {
+    if (eventLogTaskHandle == nullptr) break;
+    eventLogFlushRequest = true;
+    xTaskNotifyGive(eventLogTaskHandle);
+    vTaskDelay(pdMS_TO_TICKS(20));
+  }
+#else
+  eventLog.flush();
+#endif
+}
+
+#endif // EVENT_LOG_FORMAT_ONLY
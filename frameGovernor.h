@@ -0,0 +1,188 @@
+/**
+ * @file frameGovernor.h
+ * @brief Frame-rate governor of the analysis modes
+ *
+ * This file decouples the analysis rate of the tool modes from the display rate. Each
+ * call of a mode captures and analyzes a block of sound, but the framebuffer is only drawn
+ * and sent to the panel when a frame is due at the target FPS. Between two frames the
+ * spectra are accumulated (max-hold or average), so no spectral data is lost to the
+ * display I/O.
+ *
+ * The governor counts the analyses and the rendered frames, and reports the achieved
+ * analysis rate and render FPS every second.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include <string.h>
+#include <complex.h>
+
+// ---------- Constants --------------
+/**
+ * @brief Default target of rendered frames per second. A capture of 1024 samples at
+ * 16 kHz takes 64 ms, so the analysis runs at 15.6 Hz at most: 5 FPS draws about one
+ * analysis in three and accumulates the others.
+ */
+const unsigned char DEFAULT_TARGET_FPS = 5;
+
+/**
+ * @brief Accumulation of the spectra between two frames.
+ */
+typedef enum {
+  ACCUMULATE_MAX_HOLD,  ///< Maximum of each bin
+  ACCUMULATE_AVERAGE    ///< Average of each bin
+} AccumulateMode;
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Accumulates the real part of N spectrum bins between two rendered frames.
+ * @tparam N Number of bins.
+ */
+template <unsigned short N>
+struct SpectrumAccumulator {
+  float bins[N]; /**< Accumulated bins. */
+  unsigned short count; /**< Spectra accumulated since the last reset. */
+  AccumulateMode mode; /**< Accumulation mode. */
+
+  /**
+   * @brief Clears the accumulator.
+   * @param m Accumulation mode.
+   */
+  void reset(AccumulateMode m) {
+    mode = m;
+    reset();
+  }
+
+  /**
+   * @brief Clears the accumulator, keeping the mode.
+   */
+  void reset() {
+    memset(bins, 0, sizeof(bins));
+    count = 0;
+  }
+
+  /**
+   * @brief Adds a spectrum.
+   * @param data The spectrum, N bins or more.
+   */
+  void add(const float _Complex *data) {
+    for (unsigned short i = 0; i < N; i++) {
+      float v = creal(data[i]);
+      if (mode == ACCUMULATE_AVERAGE) bins[i] += v;
+      else if (count == 0 or v > bins[i]) bins[i] = v;
+    }
+    count++;
+  }
+
+  /**
+   * @brief Writes the accumulated spectrum and clears the accumulator.
+   * @param data Output spectrum, N bins. Not changed if nothing was accumulated.
+   * @param gain Scale of the output.
+   */
+  void take(float _Complex *data, float gain = 1.0f) {
+    if (count == 0) return;
+    float scale = mode == ACCUMULATE_AVERAGE ? gain / count : gain;
+    for (unsigned short i = 0; i < N; i++) data[i] = bins[i] * scale;
+    reset();
+  }
+};
+
+/**
+ * @namespace frameGovernor
+ * @brief Namespace for the state of the frame-rate governor.
+ */
+namespace frameGovernor {
+  unsigned long framePeriod = 1000000ul / DEFAULT_TARGET_FPS; /**< Microseconds between frames. */
+  unsigned long lastFrame = 0; /**< micros() of the last frame slot. */
+  bool render = true; /**< True if the current call renders a frame. */
+  unsigned long analyses = 0; /**< Analyses in the current second. */
+  unsigned long frames = 0; /**< Frames in the current second. */
+  unsigned long windowStart = 0; /**< millis() of the start of the current second. */
+  float analysisHz = 0; /**< Analyses per second of the last second. */
+  float renderFps = 0; /**< Frames per second of the last second. */
+}
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Sets the target FPS.
+ * @param fps Frames per second, 0 to render on every call (benchmarks).
+ */
+void setTargetFps(unsigned char fps);
+
+/**
+ * @brief Starts a call of a mode: decides if it renders a frame.
+ * @param force True to render anyway (e.g. the first call of a mode).
+ * @return True if the call must draw and send a frame.
+ */
+bool governorStart(bool force);
+
+/**
+ * @brief Tells if the current call renders a frame.
+ * @return True if the mode must draw.
+ */
+bool governorRender();
+
+/**
+ * @brief Counts an analysis (capture and FFT).
+ */
+void governorAnalysis();
+
+/**
+ * @brief Ends a call of a mode. Counts the frame if it was rendered.
+ * @return True at the end of each second, when the rates are updated.
+ */
+bool governorEnd();
+
+/**
+ * @brief Prints the achieved analysis rate and render FPS.
+ * @param out Output, e.g. Serial.
+ */
+void printFrameRates(Print &out);
+
+// ---------- Code --------------
+void setTargetFps(unsigned char fps) {
+  frameGovernor::framePeriod = fps > 0 ? 1000000ul / fps : 0;
+}
+
+bool governorStart(bool force) {
+  frameGovernor::render = force or (micros() - frameGovernor::lastFrame >= frameGovernor::framePeriod);
+  return frameGovernor::render;
+}
+
+bool governorRender() {
+  return frameGovernor::render;
+}
+
+void governorAnalysis() {
+  frameGovernor::analyses++;
+}
+
+bool governorEnd() {
+  if (frameGovernor::render) { // Keep the frame phase, unless a frame was missed.
+    unsigned long now = micros();
+    bool late = now - frameGovernor::lastFrame >= 2 * frameGovernor::framePeriod;
+    frameGovernor::lastFrame = late ? now : frameGovernor::lastFrame + frameGovernor::framePeriod;
+    frameGovernor::frames++;
+  }
+
+  unsigned long elapsed = millis() - frameGovernor::windowStart;
+  if (elapsed < 1000ul) return false;
+  frameGovernor::analysisHz = frameGovernor::analyses * 1000.0f / elapsed;
+  frameGovernor::renderFps = frameGovernor::frames * 1000.0f / elapsed;
+  frameGovernor::analyses = 0;
+  frameGovernor::frames = 0;
+  frameGovernor::windowStart = millis();
+  return true;
+}
+
+void printFrameRates(Print &out) {
+  out.print(F("Analysis: "));
+  out.print(frameGovernor::analysisHz, 1);
+  out.print(F(" Hz, render: "));
+  out.print(frameGovernor::renderFps, 1);
+  out.println(F(" FPS"));
+}
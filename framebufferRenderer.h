@@ -0,0 +1,222 @@
+/**
+ * @file framebufferRenderer.h
+ * @brief Headless renderer
+ *
+ * This file contains a Renderer that keeps the frame in memory instead of sending it to
+ * the OLED panel, so the display modes can run and be measured on a host (define
+ * HEADLESS_DISPLAY, see display.h).
+ *
+ * For each frame (from one display() to the next) it counts the pixel operations, the
+ * framebuffer bytes touched and the bytes the OLED panel would receive (same PanelTransfer
+ * planning as PartialSSD1306), and it can dump every frame as a binary PBM image.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include "renderer.h"
+#include "panelTransfer.h"
+#include "cycleTelemetry.h"
+
+/**
+ * @brief Maximum framebuffer size (128x64, 1 bit per pixel).
+ */
+const unsigned short FRAMEBUFFER_MAX_BYTES = 128 * 64 / 8;
+
+/**
+ * @brief Draw cost of a frame.
+ */
+struct FrameStats {
+  unsigned long pixelWrites; /**< Pixels written by the drawing primitives. */
+  unsigned long byteWrites; /**< Framebuffer bytes touched, direct writes included. */
+  unsigned long panelBytes; /**< Bytes the panel would receive over I2C, set on display(). */
+};
+
+/**
+ * @class FramebufferRenderer
+ * @brief In-memory 1-bit framebuffer with frame dumps and draw cost counters.
+ */
+class FramebufferRenderer : public Renderer {
+private:
+  uint8_t frame[FRAMEBUFFER_MAX_BYTES]; /**< Framebuffer, SSD1306 page layout. */
+  FrameStats current; /**< Cost of the frame being drawn. */
+  FrameStats last; /**< Cost of the last finished frame. */
+  unsigned long frames; /**< Finished frames. */
+  const char *dumpPattern; /**< printf pattern of the dump files, nullptr to disable. */
+  PanelTransfer transfer; /**< Panel transfer model. */
+
+  /**
+   * @brief Marks a rectangle as changed in the panel transfer model.
+   * @param x0 Left column, on the screen.
+   * @param x1 Right column, on the screen.
+   * @param y0 Top row, on the screen.
+   * @param y1 Bottom row, on the screen.
+   */
+  void touch(short x0, short x1, short y0, short y1) {
+    transfer.markDirty(x0, x1, y0 / 8, y1 / 8);
+  }
+
+  /**
+   * @brief Sets, clears or inverts a pixel without counting it.
+   * @param x Column.
+   * @param y Row.
+   * @param color SSD1306_WHITE, SSD1306_BLACK or SSD1306_INVERSE.
+   */
+  void setPixel(int16_t x, int16_t y, uint16_t color) {
+    uint8_t &b = frame[(y / 8) * WIDTH + x];
+    uint8_t mask = 1 << (y & 7);
+    switch (color) {
+      case SSD1306_WHITE: b |= mask; break;
+      case SSD1306_BLACK: b &= ~mask; break;
+      case SSD1306_INVERSE: b ^= mask; break;
+    }
+  }
+
+public:
+  /**
+   * @brief Constructs a cleared framebuffer.
+   * @param w Width in pixels.
+   * @param h Height in pixels, multiple of 8.
+   */
+  FramebufferRenderer(int16_t w, int16_t h)
+    : Renderer(w, h), current({0, 0, 0}), last({0, 0, 0}), frames(0), dumpPattern(nullptr),
+      transfer(w, h / 8, PANEL_WIRE_MAX) {
+    memset(frame, 0, sizeof(frame));
+  }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+    if (x < 0 or y < 0 or x >= WIDTH or y >= HEIGHT) return;
+    setPixel(x, y, color);
+    touch(x, x, y, y);
+    current.pixelWrites++;
+    current.byteWrites++;
+  }
+
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+    if (x < 0 or x >= WIDTH) return;
+    short y0 = max((short)0, (short)y);
+    short y1 = min((short)(HEIGHT - 1), (short)(y + h - 1));
+    if (y0 > y1) return;
+    for (short j = y0; j <= y1; j++) setPixel(x, j, color);
+    touch(x, x, y0, y1);
+    current.pixelWrites += y1 - y0 + 1;
+    current.byteWrites += y1 / 8 - y0 / 8 + 1;
+  }
+
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+    if (y < 0 or y >= HEIGHT) return;
+    short x0 = max((short)0, (short)x);
+    short x1 = min((short)(WIDTH - 1), (short)(x + w - 1));
+    if (x0 > x1) return;
+    for (short i = x0; i <= x1; i++) setPixel(i, y, color);
+    touch(x0, x1, y, y);
+    current.pixelWrites += x1 - x0 + 1;
+    current.byteWrites += x1 - x0 + 1;
+  }
+
+  void clearDisplay() override {
+    memset(frame, 0, WIDTH * HEIGHT / 8);
+    touch(0, WIDTH - 1, 0, HEIGHT - 1);
+    current.byteWrites += WIDTH * HEIGHT / 8;
+  }
+
+  /**
+   * @brief Ends the frame: saves its cost and dumps it if enabled.
+   */
+  void display() override {
+    CYCLE_BEGIN(CYC_DISPLAY);
+    if (dumpPattern != nullptr) {
+      char path[256];
+      snprintf(path, sizeof(path), dumpPattern, frames);
+      writePBM(path);
+    }
+    current.panelBytes = transfer.flush(frame, [](const PanelWindow &) {});
+    last = current;
+    current = {0, 0, 0};
+    frames++;
+    CYCLE_END(CYC_DISPLAY);
+  }
+
+  uint8_t *getBuffer() override {
+    return frame;
+  }
+
+  void markDirty(int16_t x, int16_t y, int16_t w, int16_t h) override {
+    short x0 = max((short)0, (short)x);
+    short x1 = min((short)(WIDTH - 1), (short)(x + w - 1));
+    short y0 = max((short)0, (short)y);
+    short y1 = min((short)(HEIGHT - 1), (short)(y + h - 1));
+    if (x0 > x1 or y0 > y1) return;
+    touch(x0, x1, y0, y1);
+    current.byteWrites += (x1 - x0 + 1) * (y1 / 8 - y0 / 8 + 1);
+  }
+
+  /**
+   * @brief Gets a pixel.
+   * @param x Column.
+   * @param y Row.
+   * @return True if the pixel is lit.
+   */
+  bool getPixel(int16_t x, int16_t y) const {
+    if (x < 0 or y < 0 or x >= WIDTH or y >= HEIGHT) return false;
+    return frame[(y / 8) * WIDTH + x] & (1 << (y & 7));
+  }
+
+  /**
+   * @brief Enables the dump of every frame on display().
+   * @param pattern printf pattern with the frame number, e.g. "frame_%05lu.pbm".
+   *                nullptr disables the dump.
+   */
+  void dumpFrames(const char *pattern) {
+    dumpPattern = pattern;
+  }
+
+  /**
+   * @brief Writes the framebuffer as a binary PBM (P4) image. Lit pixels are white.
+   * @param path Path of the image.
+   * @return True on success.
+   */
+  bool writePBM(const char *path) const {
+    FILE *file = fopen(path, "wb");
+    if (file == nullptr) return false;
+    fprintf(file, "P4\n%d %d\n", WIDTH, HEIGHT);
+    for (short y = 0; y < HEIGHT; y++) {
+      for (short x = 0; x < WIDTH; x += 8) {
+        uint8_t bits = 0;
+        for (short i = 0; i < 8; i++) {
+          if (x + i < WIDTH and !getPixel(x + i, y)) bits |= 0x80 >> i; // PBM: 1 is black.
+        }
+        fputc(bits, file);
+      }
+    }
+    return fclose(file) == 0;
+  }
+
+  /**
+   * @brief Gets the cost of the frame being drawn.
+   * @return Counters since the last display().
+   */
+  const FrameStats &currentFrame() const {
+    return current;
+  }
+
+  /**
+   * @brief Gets the cost of the last finished frame.
+   * @return Counters of the last frame.
+   */
+  const FrameStats &lastFrame() const {
+    return last;
+  }
+
+  /**
+   * @brief Gets the number of finished frames.
+   * @return Calls to display().
+   */
+  unsigned long frameCount() const {
+    return frames;
+  }
+};
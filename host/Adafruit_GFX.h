@@ -0,0 +1,210 @@
+/**
+ * @file Adafruit_GFX.h
+ * @brief Adafruit_GFX subset of the host builds
+ *
+ * This file replaces the Adafruit GFX library in the host builds. The drawing primitives
+ * the sketch uses follow the library algorithms (line, rectangles, XBM bitmaps, classic
+ * 6x8 text cells with wrap), so the pixels written and the text extents are the same as
+ * on the device.
+ *
+ * The glyphs are placeholders made from the character code, not the library font: text
+ * lands in the right cells but doesn't read. Frame hashes of the host builds are only
+ * comparable with other host builds.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include "Arduino.h"
+
+/**
+ * @class Adafruit_GFX
+ * @brief Drawing primitives over an abstract drawPixel().
+ */
+class Adafruit_GFX : public Print {
+protected:
+  const int16_t WIDTH; /**< Physical width. */
+  const int16_t HEIGHT; /**< Physical height. */
+  int16_t _width; /**< Width with the rotation. */
+  int16_t _height; /**< Height with the rotation. */
+  int16_t cursor_x; /**< Column of the text cursor. */
+  int16_t cursor_y; /**< Row of the text cursor. */
+  uint16_t textcolor; /**< Text color. */
+  uint16_t textbgcolor; /**< Text background, same as textcolor for transparent. */
+  uint8_t textsize_x; /**< Horizontal text scale. */
+  uint8_t textsize_y; /**< Vertical text scale. */
+  uint8_t rotation; /**< Rotation, only 0 is used. */
+  bool wrap; /**< Wrap the text at the right edge. */
+  bool _cp437; /**< Use the full code page 437. */
+
+  /**
+   * @brief Gets a column of the placeholder glyph of a character.
+   * @param c The character.
+   * @param i The column, 0 to 4.
+   * @return 7 rows, bit 0 on top.
+   */
+  static uint8_t glyphColumn(unsigned char c, int8_t i) {
+    if (c == ' ' or c == 0) return 0;
+    uint32_t h = (c + 1) * 2654435761u;
+    return ((h >> (i * 5)) | (i == 0 ? 0x41 : 0)) & 0x7F;
+  }
+
+public:
+  /**
+   * @brief Constructs the drawing surface.
+   * @param w Width in pixels.
+   * @param h Height in pixels.
+   */
+  Adafruit_GFX(int16_t w, int16_t h)
+    : WIDTH(w), HEIGHT(h), _width(w), _height(h), cursor_x(0), cursor_y(0), textcolor(0xFFFF),
+      textbgcolor(0xFFFF), textsize_x(1), textsize_y(1), rotation(0), wrap(true), _cp437(false) {}
+
+  virtual ~Adafruit_GFX() {}
+
+  virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+  virtual void startWrite() {}
+  virtual void writePixel(int16_t x, int16_t y, uint16_t color) { drawPixel(x, y, color); }
+  virtual void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { drawFastVLine(x, y, h, color); }
+  virtual void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { drawFastHLine(x, y, w, color); }
+  virtual void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { fillRect(x, y, w, h, color); }
+  virtual void endWrite() {}
+
+  virtual void writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep) {
+      std::swap(x0, y0);
+      std::swap(x1, y1);
+    }
+    if (x0 > x1) {
+      std::swap(x0, x1);
+      std::swap(y0, y1);
+    }
+    int16_t dx = x1 - x0;
+    int16_t dy = abs(y1 - y0);
+    int16_t err = dx / 2;
+    int16_t ystep = y0 < y1 ? 1 : -1;
+    for (; x0 <= x1; x0++) {
+      if (steep) writePixel(y0, x0, color);
+      else writePixel(x0, y0, color);
+      err -= dy;
+      if (err < 0) {
+        y0 += ystep;
+        err += dx;
+      }
+    }
+  }
+
+  virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    startWrite();
+    writeLine(x, y, x, y + h - 1, color);
+    endWrite();
+  }
+
+  virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    startWrite();
+    writeLine(x, y, x + w - 1, y, color);
+    endWrite();
+  }
+
+  virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    startWrite();
+    for (int16_t i = x; i < x + w; i++) writeFastVLine(i, y, h, color);
+    endWrite();
+  }
+
+  virtual void fillScreen(uint16_t color) {
+    fillRect(0, 0, _width, _height, color);
+  }
+
+  virtual void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    if (x0 == x1) {
+      if (y0 > y1) std::swap(y0, y1);
+      drawFastVLine(x0, y0, y1 - y0 + 1, color);
+    } else if (y0 == y1) {
+      if (x0 > x1) std::swap(x0, x1);
+      drawFastHLine(x0, y0, x1 - x0 + 1, color);
+    } else {
+      startWrite();
+      writeLine(x0, y0, x1, y1, color);
+      endWrite();
+    }
+  }
+
+  virtual void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    startWrite();
+    writeFastHLine(x, y, w, color);
+    writeFastHLine(x, y + h - 1, w, color);
+    writeFastVLine(x, y, h, color);
+    writeFastVLine(x + w - 1, y, h, color);
+    endWrite();
+  }
+
+  void drawXBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color) {
+    int16_t byteWidth = (w + 7) / 8;
+    uint8_t b = 0;
+    startWrite();
+    for (int16_t j = 0; j < h; j++, y++) {
+      for (int16_t i = 0; i < w; i++) {
+        if (i & 7) b >>= 1;
+        else b = bitmap[j * byteWidth + i / 8];
+        if (b & 0x01) writePixel(x + i, y, color);
+      }
+    }
+    endWrite();
+  }
+
+  void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size_x, uint8_t size_y) {
+    if (x >= _width or y >= _height or (x + 6 * size_x - 1) < 0 or (y + 8 * size_y - 1) < 0) return;
+    if (!_cp437 and c >= 176) c++;
+    startWrite();
+    for (int8_t i = 0; i < 5; i++) {
+      uint8_t line = glyphColumn(c, i);
+      for (int8_t j = 0; j < 8; j++, line >>= 1) {
+        if (line & 1) {
+          if (size_x == 1 and size_y == 1) writePixel(x + i, y + j, color);
+          else writeFillRect(x + i * size_x, y + j * size_y, size_x, size_y, color);
+        } else if (bg != color) {
+          if (size_x == 1 and size_y == 1) writePixel(x + i, y + j, bg);
+          else writeFillRect(x + i * size_x, y + j * size_y, size_x, size_y, bg);
+        }
+      }
+    }
+    if (bg != color) { // Opaque: last column.
+      if (size_x == 1 and size_y == 1) writeFastVLine(x + 5, y, 8, bg);
+      else writeFillRect(x + 5 * size_x, y, size_x, 8 * size_y, bg);
+    }
+    endWrite();
+  }
+
+  size_t write(uint8_t c) override {
+    if (c == '\n') {
+      cursor_x = 0;
+      cursor_y += textsize_y * 8;
+    } else if (c != '\r') {
+      if (wrap and (cursor_x + textsize_x * 6) > _width) {
+        cursor_x = 0;
+        cursor_y += textsize_y * 8;
+      }
+      drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize_x, textsize_y);
+      cursor_x += textsize_x * 6;
+    }
+    return 1;
+  }
+  using Print::write;
+
+  void setCursor(int16_t x, int16_t y) { cursor_x = x; cursor_y = y; }
+  void setTextColor(uint16_t c) { textcolor = textbgcolor = c; }
+  void setTextColor(uint16_t c, uint16_t bg) { textcolor = c; textbgcolor = bg; }
+  void setTextSize(uint8_t s) { textsize_x = textsize_y = s > 0 ? s : 1; }
+  void setTextWrap(bool w) { wrap = w; }
+  void cp437(bool x = true) { _cp437 = x; }
+  void setRotation(uint8_t r) { rotation = r & 3; }
+  uint8_t getRotation() const { return rotation; }
+  int16_t width() const { return _width; }
+  int16_t height() const { return _height; }
+  int16_t getCursorX() const { return cursor_x; }
+  int16_t getCursorY() const { return cursor_y; }
+};
@@ -0,0 +1,253 @@
+/**
+ * @file Arduino.h
+ * @brief Arduino core subset of the host builds
+ *
+ * This file replaces the Arduino ESP32 core in the host builds (benchmarks and
+ * simulation, see host/). It has the types, String, Print, Serial, timing, pins, ADC and
+ * sleep functions the sketch uses.
+ *
+ * Time is virtual and deterministic: an ADC read takes one sample period, a delay()
+ * advances the clock and each micros() or millis() call advances it 1 ns, so busy-waits
+ * end. The microphone returns the samples of hostMicSource, one per read or, with
+ * hostMicClocked, the sample of the virtual time, see arduinoHost.cpp. The P button reads
+ * hostButtonSource, and deep sleep calls hostDeepSleep, so a simulation can script them.
+ * The interrupt of the button runs when the clock passes an edge of hostButtonSource or
+ * hostButtonLevel, between two instructions of the sketch as on the device.
+ *
+ * Build the host tools with -DHEADLESS_DISPLAY -Ihost.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+#define ARDUINO 10819
+#define PROGMEM
+#define F(x) (x)
+#define IRAM_ATTR
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define DEC 10
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// ---------------- String ----------------------
+/**
+ * @brief Subset of the Arduino String.
+ */
+class String {
+private:
+  std::string s; /**< Characters. */
+
+public:
+  String(const char *c = "") : s(c) {}
+  String(const std::string &c) : s(c) {}
+  String(char c) : s(1, c) {}
+  String(int v) : s(std::to_string(v)) {}
+  String(unsigned int v) : s(std::to_string(v)) {}
+  String(long v) : s(std::to_string(v)) {}
+  String(unsigned long v) : s(std::to_string(v)) {}
+  String(double v, unsigned char decimals = 2) {
+    char b[32];
+    snprintf(b, sizeof(b), "%.*f", decimals, v);
+    s = b;
+  }
+
+  unsigned int length() const { return s.size(); }
+  const char *c_str() const { return s.c_str(); }
+  String &operator+=(const String &o) { s += o.s; return *this; }
+  friend String operator+(const String &a, const String &b) { return String(a.s + b.s); }
+  bool operator==(const String &o) const { return s == o.s; }
+  bool operator!=(const String &o) const { return s != o.s; }
+};
+
+// ---------------- Print ----------------------
+/**
+ * @brief Subset of the Arduino Print.
+ */
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+
+  virtual size_t write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+  }
+
+  size_t write(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+
+  size_t print(const char *str) { return write(str); }
+  size_t print(const String &str) { return write(str.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char v) { return print((unsigned long)v); }
+  size_t print(int v) { return print((long)v); }
+  size_t print(unsigned int v) { return print((unsigned long)v); }
+  size_t print(long v) { return print(String(v)); }
+  size_t print(unsigned long v) { return print(String(v)); }
+  size_t print(double v, int decimals = 2) { return print(String(v, decimals)); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(const T &v) { return print(v) + println(); }
+  size_t println(double v, int decimals) { return print(v, decimals) + println(); }
+};
+
+extern FILE *hostSerialOut; /**< Output of Serial, stdout by default, nullptr to discard it. */
+
+/**
+ * @brief Serial port, written to hostSerialOut.
+ */
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t c) override { return hostSerialOut != nullptr ? fwrite(&c, 1, 1, hostSerialOut) : 1; }
+  size_t write(const uint8_t *buffer, size_t size) override { return hostSerialOut != nullptr ? fwrite(buffer, 1, size, hostSerialOut) : size; }
+  using Print::write;
+  int available() { return 0; }
+  int read() { return -1; }
+  void flush() { if (hostSerialOut != nullptr) fflush(hostSerialOut); }
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// ---------------- Time and pins ----------------------
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t level);
+int analogRead(uint8_t pin);
+void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t interrupt);
+void noInterrupts();
+void interrupts();
+inline uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// ---------------- ESP32 ----------------------
+typedef enum { ADC_0db, ADC_2_5db, ADC_6db, ADC_11db } adc_attenuation_t;
+void analogReadResolution(uint8_t bits);
+void analogSetClockDiv(uint8_t div);
+void analogSetAttenuation(adc_attenuation_t attenuation);
+void analogSetPinAttenuation(uint8_t pin, adc_attenuation_t attenuation);
+
+typedef enum { GPIO_NUM_0 = 0, GPIO_NUM_1, GPIO_NUM_2 } gpio_num_t;
+typedef enum {
+  ESP_SLEEP_WAKEUP_UNDEFINED, ESP_SLEEP_WAKEUP_ALL, ESP_SLEEP_WAKEUP_EXT0,
+  ESP_SLEEP_WAKEUP_EXT1, ESP_SLEEP_WAKEUP_TIMER
+} esp_sleep_source_t;
+esp_sleep_source_t esp_sleep_get_wakeup_cause();
+int esp_sleep_enable_ext0_wakeup(gpio_num_t pin, int level);
+int esp_sleep_enable_timer_wakeup(uint64_t us);
+int esp_light_sleep_start();
+void esp_deep_sleep_start();
+
+// ---------------- Host hooks ----------------------
+/**
+ * @brief Source of the microphone samples.
+ * @param n Index of the sample, from 0.
+ * @return ADC value (12 bits).
+ */
+typedef int (*HostMicSource)(unsigned long n);
+
+/**
+ * @brief Source of the P button level.
+ * @param nanos Virtual time, in nanoseconds.
+ * @return HIGH (released) or LOW (pressed).
+ */
+typedef int (*HostButtonSource)(unsigned long long nanos);
+
+extern HostMicSource hostMicSource; /**< Microphone source, hostSyntheticSample by default. */
+extern HostButtonSource hostButtonSource; /**< P button source, nullptr to read hostButtonLevel. */
+extern int hostButtonLevel; /**< Level of the P button, HIGH (released) by default. Set it to inject a press. */
+extern unsigned long long hostNanos; /**< Virtual clock, in nanoseconds. */
+extern unsigned long hostMicSamples; /**< Index of the next microphone sample. */
+extern bool hostMicClocked; /**< True: a read takes the sample of its virtual time (simulation); false: the next one (benchmarks). */
+extern esp_sleep_source_t hostWakeupCause; /**< Wake-up cause of the boot, EXT0 (microphone) by default. */
+extern void (*hostDeepSleep)(); /**< Called by esp_deep_sleep_start(), nullptr exits the program. */
+
+/**
+ * @brief Deterministic test signal: a 1400 Hz tone, a 300 - 6000 Hz chirp every 2 s and
+ * noise around the silence level.
+ * @param n Index of the sample, at 16 kHz.
+ * @return ADC value.
+ */
+int hostSyntheticSample(unsigned long n);
+
+// ---------------- Scripted inputs (hostInput.cpp) ----------------------
+/**
+ * @brief Loads a recording as the microphone, see hostRecordedSample.
+ * @param path WAV file, 16-bit PCM at any rate (first channel).
+ * @return False if the file can't be read or has another format.
+ */
+bool hostLoadWav(const char *path);
+
+/**
+ * @brief Loads a recording as the microphone, see hostRecordedSample.
+ * @param path Text file with an ADC value (12 bits, 16 kHz) in the first column of each line.
+ * @return False if the file can't be read or has no samples.
+ */
+bool hostLoadCsv(const char *path);
+
+/**
+ * @brief Duration of the loaded recording.
+ * @return Samples at 16 kHz.
+ */
+unsigned long hostRecordedSamples();
+
+/**
+ * @brief Microphone source that plays the loaded recording, then silence.
+ * @param n Index of the sample, at 16 kHz.
+ * @return ADC value.
+ */
+int hostRecordedSample(unsigned long n);
+
+/**
+ * @brief Schedules a change of the P button.
+ * @param ms Virtual time of the change, in ms.
+ * @param level HIGH (released) or LOW (pressed).
+ */
+void hostScheduleButton(unsigned long ms, int level);
+
+/**
+ * @brief Loads a button script. Each line is a time in seconds and an action: press,
+ * release or click (a 100 ms press). Lines starting with # are comments.
+ * @param path Path of the script.
+ * @return False if the file can't be read or a line is not valid.
+ */
+bool hostLoadButtonScript(const char *path);
+
+/**
+ * @brief Button source that plays the scheduled changes.
+ * @param nanos Virtual time, in nanoseconds.
+ * @return Level of the last change up to the time, HIGH before the first one.
+ */
+int hostScriptedButton(unsigned long long nanos);
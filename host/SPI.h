@@ -0,0 +1,11 @@
+/**
+ * @file SPI.h
+ * @brief SPI placeholder of the host builds
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include "Arduino.h"
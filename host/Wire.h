@@ -0,0 +1,28 @@
+/**
+ * @file Wire.h
+ * @brief I2C subset of the host builds
+ *
+ * The host builds draw in memory (HEADLESS_DISPLAY), the bus only has to exist.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include "Arduino.h"
+
+/**
+ * @brief I2C bus that discards every transmission.
+ */
+class TwoWire {
+public:
+  bool begin(int sda = -1, int scl = -1) { return true; }
+  void setClock(uint32_t frequency) {}
+  void beginTransmission(uint8_t address) {}
+  size_t write(uint8_t data) { return 1; }
+  uint8_t endTransmission(bool stop = true) { return 0; }
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
@@ -0,0 +1,181 @@
+/**
+ * @file arduinoHost.cpp
+ * @brief Arduino core subset of the host builds, code
+ *
+ * Virtual clock, pins and microphone of the host builds, see Arduino.h.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "driver/rtc_io.h"
+
+/**
+ * @brief Time of an ADC read: one sample period at 16 kHz.
+ */
+const unsigned long long HOST_ADC_NANOS = 62500;
+
+/**
+ * @brief Pin of the microphone, see board.h.
+ */
+const uint8_t HOST_MIC_PIN = 2;
+
+/**
+ * @brief Pin of the P button, see board.h.
+ */
+const uint8_t HOST_BUTTON_PIN = 0;
+
+FILE *hostSerialOut = stdout;
+HardwareSerial Serial;
+TwoWire Wire;
+TwoWire Wire1;
+
+HostMicSource hostMicSource = hostSyntheticSample;
+HostButtonSource hostButtonSource = nullptr;
+int hostButtonLevel = HIGH;
+unsigned long long hostNanos = 0;
+unsigned long hostMicSamples = 0;
+bool hostMicClocked = false;
+esp_sleep_source_t hostWakeupCause = ESP_SLEEP_WAKEUP_EXT0;
+void (*hostDeepSleep)() = nullptr;
+
+/**
+ * @brief Interrupt of the P button.
+ */
+struct HostInterrupt {
+  void (*isr)(); /**< Routine, nullptr if detached. */
+  int mode; /**< RISING, FALLING or CHANGE. */
+  int level; /**< Level at the last check. */
+  bool masked; /**< Between noInterrupts() and interrupts(), or running. */
+};
+
+HostInterrupt hostButtonInterrupt = {nullptr, CHANGE, HIGH, false};
+uint64_t hostTimerWakeup = 0; /**< Light sleep time (us). */
+
+/**
+ * @brief Level of the P button.
+ * @return HIGH (released) or LOW (pressed).
+ */
+static int hostButton() {
+  return hostButtonSource != nullptr ? hostButtonSource(hostNanos) : hostButtonLevel;
+}
+
+/**
+ * @brief Runs the interrupt of the button if its level has changed. Called by every advance
+ * of the clock.
+ */
+static void hostCheckInterrupts() {
+  HostInterrupt &i = hostButtonInterrupt;
+  if (i.isr == nullptr or i.masked) return;
+  int level = hostButton();
+  if (level == i.level) return;
+  i.level = level;
+  if (i.mode == CHANGE or (i.mode == RISING and level == HIGH) or (i.mode == FALLING and level == LOW)) {
+    i.masked = true; // The routine reads the clock.
+    i.isr();
+    i.masked = false;
+  }
+}
+
+int hostSyntheticSample(unsigned long n) {
+  const double rate = 16000.0;
+  double t = n / rate;
+  double sweep = fmod(t, 2.0); // Chirp from 300 to 6000 Hz in 2 s.
+  double chirpPhase = 2 * M_PI * (300.0 * sweep + (6000.0 - 300.0) / 4.0 * sweep * sweep);
+  uint32_t noise = (uint32_t)n * 2654435761u; // Hash of the index, same noise on every run.
+  noise ^= noise >> 15;
+  return 1450 + (int)(500 * sin(2 * M_PI * 1400.0 * t) + 300 * sin(chirpPhase)) + (int)(noise % 61) - 30;
+}
+
+unsigned long millis() {
+  hostNanos++;
+  hostCheckInterrupts();
+  return hostNanos / 1000000ull;
+}
+
+unsigned long micros() {
+  hostNanos++;
+  hostCheckInterrupts();
+  return hostNanos / 1000ull;
+}
+
+void delay(unsigned long ms) {
+  hostNanos += ms * 1000000ull;
+  hostCheckInterrupts();
+}
+
+void delayMicroseconds(unsigned int us) {
+  hostNanos += us * 1000ull;
+  hostCheckInterrupts();
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+int digitalRead(uint8_t pin) {
+  return pin == HOST_BUTTON_PIN ? hostButton() : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {}
+
+int analogRead(uint8_t pin) {
+  hostNanos += HOST_ADC_NANOS;
+  hostCheckInterrupts();
+  if (pin != HOST_MIC_PIN) return 2048; // Battery: charged.
+  if (hostMicClocked) hostMicSamples = hostNanos / HOST_ADC_NANOS;
+  return hostMicSource(hostMicSamples++);
+}
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode) {
+  if (interrupt != HOST_BUTTON_PIN) return;
+  hostButtonInterrupt = {isr, mode, hostButton(), false};
+}
+
+void detachInterrupt(uint8_t interrupt) {
+  if (interrupt == HOST_BUTTON_PIN) hostButtonInterrupt.isr = nullptr;
+}
+
+void noInterrupts() {
+  hostButtonInterrupt.masked = true;
+}
+
+void interrupts() {
+  hostButtonInterrupt.masked = false;
+  hostCheckInterrupts(); // An edge while masked is pending.
+}
+
+void analogReadResolution(uint8_t bits) {}
+void analogSetClockDiv(uint8_t div) {}
+void analogSetAttenuation(adc_attenuation_t attenuation) {}
+void analogSetPinAttenuation(uint8_t pin, adc_attenuation_t attenuation) {}
+
+esp_sleep_source_t esp_sleep_get_wakeup_cause() {
+  return hostWakeupCause;
+}
+
+int esp_sleep_enable_ext0_wakeup(gpio_num_t pin, int level) {
+  return 0;
+}
+
+int esp_sleep_enable_timer_wakeup(uint64_t us) {
+  hostTimerWakeup = us;
+  return 0;
+}
+
+int esp_light_sleep_start() {
+  hostNanos += hostTimerWakeup * 1000ull;
+  hostCheckInterrupts();
+  return 0;
+}
+
+void esp_deep_sleep_start() {
+  if (hostDeepSleep != nullptr) hostDeepSleep();
+  Serial.println("Deep sleep");
+  Serial.flush();
+  exit(0);
+}
+
+int rtc_gpio_pulldown_en(gpio_num_t pin) {
+  return 0;
+}
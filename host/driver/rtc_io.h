@@ -0,0 +1,13 @@
+/**
+ * @file rtc_io.h
+ * @brief RTC GPIO subset of the host builds
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include "Arduino.h"
+
+int rtc_gpio_pulldown_en(gpio_num_t pin);
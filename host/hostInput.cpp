@@ -0,0 +1,160 @@
+/**
+ * @file hostInput.cpp
+ * @brief Scripted inputs of the host builds
+ *
+ * Recordings for the microphone (WAV or a column of ADC values) and scripted changes of
+ * the P button, see the "Scripted inputs" section of Arduino.h. The simulation
+ * (simulator.cpp) links this file; the other host tools use the synthetic audio.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#include <vector>
+
+#include "Arduino.h"
+
+/**
+ * @brief Sample rate of the microphone captures.
+ */
+const unsigned long HOST_RATE = 16000;
+
+/**
+ * @brief ADC value of silence, the bias of the microphone (SILENCE in board.h).
+ */
+const int HOST_MIC_BIAS = 1450;
+
+/**
+ * @brief ADC swing of a full scale recording, the 16 bits of a WAV go to the 12 bits of the ADC.
+ */
+const int HOST_MIC_SWING = 2048;
+
+/**
+ * @brief Duration of a click of the button script, in ms.
+ */
+const unsigned long HOST_CLICK_MS = 100;
+
+/**
+ * @brief Change of the P button.
+ */
+struct ButtonChange {
+  unsigned long long nanos; /**< Virtual time of the change. */
+  int level; /**< Level from then on. */
+};
+
+std::vector<uint16_t> hostRecording; /**< ADC values of the recording, at 16 kHz. */
+std::vector<ButtonChange> hostButtonChanges; /**< Scheduled changes, sorted by time. */
+
+/**
+ * @brief Reads a little endian integer of a byte buffer.
+ * @param p The bytes.
+ * @param bytes Bytes of the integer.
+ * @return The value.
+ */
+static uint32_t readLE(const uint8_t *p, unsigned char bytes) {
+  uint32_t value = 0;
+  for (unsigned char i = 0; i < bytes; i++) value |= (uint32_t)p[i] << (8 * i);
+  return value;
+}
+
+bool hostLoadWav(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr) return false;
+  std::vector<uint8_t> wav;
+  uint8_t block[4096];
+  size_t n;
+  while ((n = fread(block, 1, sizeof(block), file)) > 0) wav.insert(wav.end(), block, block + n);
+  fclose(file);
+  if (wav.size() < 12 or memcmp(wav.data(), "RIFF", 4) != 0 or memcmp(wav.data() + 8, "WAVE", 4) != 0) return false;
+
+  // Chunks: fmt (format) and data (samples), other chunks are skipped.
+  uint16_t format = 0, channels = 0, bits = 0;
+  uint32_t rate = 0;
+  const uint8_t *samples = nullptr;
+  size_t frames = 0;
+  for (size_t pos = 12; pos + 8 <= wav.size();) {
+    uint32_t size = readLE(&wav[pos + 4], 4);
+    const uint8_t *chunk = &wav[pos + 8];
+    size_t available = std::min((size_t)size, wav.size() - pos - 8);
+    if (memcmp(&wav[pos], "fmt ", 4) == 0 and available >= 16) {
+      format = readLE(chunk, 2);
+      channels = readLE(chunk + 2, 2);
+      rate = readLE(chunk + 4, 4);
+      bits = readLE(chunk + 14, 2);
+    } else if (memcmp(&wav[pos], "data", 4) == 0 and channels > 0) {
+      samples = chunk;
+      frames = available / (2 * channels);
+    }
+    pos += 8 + size + (size & 1);
+  }
+  if (format != 1 or bits != 16 or rate == 0 or samples == nullptr) return false;
+
+  // Nearest sample at 16 kHz, first channel.
+  hostRecording.clear();
+  for (unsigned long i = 0; (unsigned long long)i * rate / HOST_RATE < frames; i++) {
+    size_t frame = (unsigned long long)i * rate / HOST_RATE;
+    int16_t s = (int16_t)readLE(samples + frame * 2 * channels, 2);
+    int adc = HOST_MIC_BIAS + s * HOST_MIC_SWING / 32768;
+    hostRecording.push_back(std::min(std::max(adc, 0), 4095));
+  }
+  return !hostRecording.empty();
+}
+
+bool hostLoadCsv(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == nullptr) return false;
+  hostRecording.clear();
+  char line[128];
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    int adc;
+    if (sscanf(line, "%d", &adc) == 1) hostRecording.push_back(std::min(std::max(adc, 0), 4095));
+  }
+  fclose(file);
+  return !hostRecording.empty();
+}
+
+unsigned long hostRecordedSamples() {
+  return hostRecording.size();
+}
+
+int hostRecordedSample(unsigned long n) {
+  return n < hostRecording.size() ? hostRecording[n] : HOST_MIC_BIAS;
+}
+
+void hostScheduleButton(unsigned long ms, int level) {
+  ButtonChange change = {ms * 1000000ull, level};
+  auto it = std::upper_bound(hostButtonChanges.begin(), hostButtonChanges.end(), change,
+                             [](const ButtonChange &a, const ButtonChange &b) { return a.nanos < b.nanos; });
+  hostButtonChanges.insert(it, change);
+}
+
+bool hostLoadButtonScript(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == nullptr) return false;
+  char line[128];
+  bool valid = true;
+  while (valid and fgets(line, sizeof(line), file) != nullptr) {
+    double seconds;
+    char action[16];
+    if (line[0] == '#' or strspn(line, " \t\r\n") == strlen(line)) continue;
+    if (sscanf(line, "%lf %15s", &seconds, action) != 2 or seconds < 0) {
+      valid = false;
+      break;
+    }
+    unsigned long ms = (unsigned long)(seconds * 1000 + 0.5);
+    if (strcmp(action, "press") == 0) hostScheduleButton(ms, LOW);
+    else if (strcmp(action, "release") == 0) hostScheduleButton(ms, HIGH);
+    else if (strcmp(action, "click") == 0) {
+      hostScheduleButton(ms, LOW);
+      hostScheduleButton(ms + HOST_CLICK_MS, HIGH);
+    } else valid = false;
+  }
+  fclose(file);
+  return valid;
+}
+
+int hostScriptedButton(unsigned long long nanos) {
+  auto it = std::upper_bound(hostButtonChanges.begin(), hostButtonChanges.end(), ButtonChange{nanos, HIGH},
+                             [](const ButtonChange &a, const ButtonChange &b) { return a.nanos < b.nanos; });
+  return it == hostButtonChanges.begin() ? HIGH : (it - 1)->level;
+}
@@ -0,0 +1,295 @@
+/**
+ * @file modeBench.cpp
+ * @brief Per-mode rendering benchmark and golden-frame check
+ *
+ * Host tool that runs every mode of selectDisplayMode() on the deterministic synthetic
+ * audio of the host builds (see Arduino.h), drawing in the headless framebuffer. For each
+ * frame it prints the render time (render_us: the step of the mode and display(), from the
+ * CYC_MODE and CYC_DISPLAY stages of cycleTelemetry.h), the time of the whole call
+ * (frame_us: also the capture of the bus, its analysis and the alert matching), the
+ * display() calls, the pixel and framebuffer byte writes and the bytes the panel would
+ * receive (both of the last display() call) and a hash of the framebuffer. The summary has
+ * the state size of each mode.
+ *
+ * The hashes are compared with a golden file and the tool fails if any frame differs, so
+ * a rendering optimization is accepted only if the output is identical. Record the golden
+ * file again (-r) when a change is meant to alter the output.
+ *
+ * The tool counts every malloc of the program for the heap probe (see textOverlay.h) and
+ * also fails if a frame of a mode allocates, so a String in a per-frame readout is caught.
+ * The frame dumps (-d) open files inside display(), so the check is skipped with them.
+ *
+ * Build: g++ -std=gnu++17 -O2 -DHEADLESS_DISPLAY -Ihost -I. -o modeBench host/modeBench.cpp host/arduinoHost.cpp fft.cpp
+ * Usage: modeBench [-n frames per mode] [-g golden file] [-r] [-d dump directory] > frames.csv
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#include <chrono>
+#include <climits>
+#include <map>
+#include <vector>
+
+#ifndef CYCLE_TELEMETRY
+#define CYCLE_TELEMETRY // Render time of each frame.
+#endif
+#include "../soundAlert-soundAnalyzer-ESP32.ino"
+
+// ---------------- Heap allocation hook ----------------------
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+/**
+ * @brief malloc of the program (glibc), counted for the heap probe.
+ * @param size Bytes.
+ * @return The block.
+ */
+extern "C" void *malloc(size_t size) {
+  heapProbe::allocations++;
+  return __libc_malloc(size);
+}
+
+/**
+ * @brief calloc of the program (glibc), counted for the heap probe.
+ * @param n Elements.
+ * @param size Bytes of an element.
+ * @return The block.
+ */
+extern "C" void *calloc(size_t n, size_t size) {
+  heapProbe::allocations++;
+  return __libc_calloc(n, size);
+}
+
+/**
+ * @brief realloc of the program (glibc), counted for the heap probe.
+ * @param ptr The block, nullptr for a new one.
+ * @param size Bytes.
+ * @return The block.
+ */
+extern "C" void *realloc(void *ptr, size_t size) {
+  heapProbe::allocations++;
+  return __libc_realloc(ptr, size);
+}
+
+/**
+ * @brief Default golden file, from the repository root.
+ */
+const char *const GOLDEN_FILE = "host/golden/modeFrames.txt";
+
+/**
+ * @brief Default number of frames per mode.
+ */
+const unsigned short BENCH_FRAMES = 20;
+
+/**
+ * @brief Maximum mismatches listed.
+ */
+const unsigned short MAX_REPORTED = 10;
+
+/**
+ * @brief Hash of a frame.
+ */
+struct FrameHash {
+  unsigned short mode; /**< Mode. */
+  unsigned short frame; /**< Frame of the mode, from 0. */
+  unsigned long long hash; /**< FNV-1a of the framebuffer. */
+};
+
+/**
+ * @brief Loads the alerts of the device and raises their intensity marks out of reach.
+ *
+ * The tool modes watch the alerts on their capture, and the 1400 Hz tone of the synthetic
+ * audio would hold the alert screen instead of the mode being measured.
+ */
+void muteAlerts() {
+  initAlerts();
+  for (short i = 0; i < N_ALERT_TYPES; i++) alerts[i].minIntensity = alerts[i].minAverageIntensity = INT_MAX;
+  for (short i = 0; i < N_SEQUENCE_TYPES; i++) {
+    for (short j = 0; j < sequences[i].nSteps; j++) {
+      sequences[i].steps[j].minIntensity = sequences[i].steps[j].minAverageIntensity = INT_MAX;
+    }
+  }
+}
+
+/**
+ * @brief Hashes a buffer with 64-bit FNV-1a.
+ * @param data The buffer.
+ * @param size Bytes of the buffer.
+ * @return The hash.
+ */
+unsigned long long fnv1a(const uint8_t *data, size_t size) {
+  unsigned long long hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+/**
+ * @brief Adds the ticks of the rendering stages measured so far.
+ * @return Ticks of cycleCount() in the step of the mode and display().
+ */
+uint64_t renderCycles() {
+  return cycleTelemetry::stages[CYC_MODE].sum + cycleTelemetry::stages[CYC_DISPLAY].sum;
+}
+
+/**
+ * @brief Reads a golden file.
+ * @param path Path of the file.
+ * @param golden Output: hash of each (mode, frame).
+ * @return False if the file can't be read.
+ */
+bool readGolden(const char *path, std::map<std::pair<unsigned short, unsigned short>, unsigned long long> &golden) {
+  FILE *file = fopen(path, "r");
+  if (file == nullptr) return false;
+  char line[128];
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    unsigned int mode, frame;
+    unsigned long long hash;
+    if (line[0] == '#' or sscanf(line, "%u %u %llx", &mode, &frame, &hash) != 3) continue;
+    golden[{mode, frame}] = hash;
+  }
+  fclose(file);
+  return true;
+}
+
+/**
+ * @brief Writes a golden file.
+ * @param path Path of the file.
+ * @param hashes The hashes.
+ * @return False if the file can't be written.
+ */
+bool writeGolden(const char *path, const std::vector<FrameHash> &hashes) {
+  FILE *file = fopen(path, "w");
+  if (file == nullptr) return false;
+  fprintf(file, "# mode frame fnv1a (host/modeBench.cpp -r)\n");
+  for (const FrameHash &h : hashes) fprintf(file, "%u %u %016llx\n", h.mode, h.frame, h.hash);
+  return fclose(file) == 0;
+}
+
+int main(int argc, char *argv[]) {
+  const char *goldenPath = GOLDEN_FILE;
+  const char *dumpDir = nullptr;
+  unsigned short frames = 0;
+  bool record = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-r") == 0) record = true;
+    else if (strcmp(argv[i], "-n") == 0 and i + 1 < argc) frames = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-g") == 0 and i + 1 < argc) goldenPath = argv[++i];
+    else if (strcmp(argv[i], "-d") == 0 and i + 1 < argc) dumpDir = argv[++i];
+    else {
+      fprintf(stderr, "Usage: %s [-n frames per mode] [-g golden file] [-r] [-d dump directory]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  // The modes keep some state across mode changes (info readouts, timers), so the frames
+  // depend on the frames of the previous modes: the check runs the frames of the golden file.
+  std::map<std::pair<unsigned short, unsigned short>, unsigned long long> golden;
+  if (!record) {
+    if (!readGolden(goldenPath, golden)) {
+      fprintf(stderr, "Can't read %s, record it with -r\n", goldenPath);
+      return 2;
+    }
+    unsigned short goldenFrames = 0; // Frames of a mode, the file may not have every mode.
+    for (const auto &g : golden) goldenFrames = max(goldenFrames, (unsigned short)(g.first.second + 1));
+    if (frames > 0 and frames != goldenFrames) {
+      fprintf(stderr, "%s has %u frames per mode, record it again with -r -n %u\n", goldenPath, goldenFrames, frames);
+      return 2;
+    }
+    frames = goldenFrames;
+  }
+  if (frames == 0) frames = BENCH_FRAMES;
+
+  hostSerialOut = nullptr; // stdout has the CSV, the stream mode would mix its frames in.
+  initSoundAnalysisTools();
+  muteAlerts();
+  setTargetFps(0); // Every call renders a frame.
+  display.clearDisplay();
+  display.display();
+
+  std::vector<FrameHash> hashes;
+  hashes.reserve(MAXMODES * frames);
+  unsigned long allocatingFrames = 0;
+  char dumpPattern[256];
+  printf("mode,frame,render_us,frame_us,displays,pixel_writes,byte_writes,panel_bytes,hash\n");
+  fprintf(stderr, "%-4s %-28s %9s %9s %9s %9s %9s %9s\n", "mode", "title", "render_us", "frame_us", "pixels", "bytes",
+          "panel", "state");
+  for (unsigned short mode = 0; mode < MAXMODES; mode++) {
+    currentMode = mode;
+    changeMode = true;
+    hostMicSamples = 0; // Every mode starts on the same audio.
+    showTitle();
+
+    double totalRenderUs = 0, totalUs = 0;
+    unsigned long totalPixels = 0, totalBytes = 0, totalPanel = 0;
+    for (unsigned short frame = 0; frame < frames; frame++) {
+      if (dumpDir != nullptr) {
+        snprintf(dumpPattern, sizeof(dumpPattern), "%s/mode%02u_frame%03u.pbm", dumpDir, mode, frame);
+        display.dumpFrames(dumpPattern);
+      }
+      unsigned long sent = display.frameCount();
+      auto start = std::chrono::steady_clock::now();
+      scheduler.service(); // As loop() does, the title task and the cycle report.
+      uint64_t renderTicks = renderCycles();
+      selectDisplayMode();
+      renderTicks = renderCycles() - renderTicks;
+      auto end = std::chrono::steady_clock::now();
+      changeMode = false;
+
+      double renderUs = (double)renderTicks / cycleTicksPerUs();
+      double us = std::chrono::duration<double, std::micro>(end - start).count();
+      sent = display.frameCount() - sent; // The counters are of the last display() call.
+      const FrameStats &stats = display.lastFrame();
+      unsigned long long hash = fnv1a(display.getBuffer(), DISPLAY_WIDTH * DISPLAY_HEIGHT / 8);
+      hashes.push_back({mode, frame, hash});
+      if (dumpDir == nullptr and heapProbe::lastFrame > 0 and ++allocatingFrames <= MAX_REPORTED) {
+        fprintf(stderr, "Mode %u frame %u: %lu heap allocations\n", mode, frame, heapProbe::lastFrame);
+      }
+      printf("%u,%u,%.1f,%.1f,%lu,%lu,%lu,%lu,%016llx\n", mode, frame, renderUs, us, sent, stats.pixelWrites, stats.byteWrites, stats.panelBytes, hash);
+      totalRenderUs += renderUs;
+      totalUs += us;
+      totalPixels += stats.pixelWrites;
+      totalBytes += stats.byteWrites;
+      totalPanel += stats.panelBytes;
+    }
+    const char *const *title = MODES[mode].title;
+    String name = String(title[0] != nullptr ? title[0] : "") + " " + (title[1] != nullptr ? title[1] : "");
+    fprintf(stderr, "%-4u %-28s %9.1f %9.1f %9lu %9lu %9lu %9zu\n", mode, name.c_str(), totalRenderUs / frames, totalUs / frames,
+            totalPixels / frames, totalBytes / frames, totalPanel / frames, MODES[mode].stateSize);
+  }
+  fprintf(stderr, "Mode state arena: %zu bytes\n", modeRunner.arenaSize());
+  display.dumpFrames(nullptr);
+  if (allocatingFrames > 0) {
+    fprintf(stderr, "%lu frames allocate on the heap\n", allocatingFrames);
+    return 1;
+  }
+
+  if (record) {
+    if (!writeGolden(goldenPath, hashes)) {
+      fprintf(stderr, "Can't write %s\n", goldenPath);
+      return 2;
+    }
+    fprintf(stderr, "Recorded %zu frames in %s\n", hashes.size(), goldenPath);
+    return 0;
+  }
+
+  unsigned long mismatches = 0;
+  for (const FrameHash &h : hashes) {
+    auto it = golden.find({h.mode, h.frame});
+    if (it != golden.end() and it->second == h.hash) continue;
+    if (++mismatches <= MAX_REPORTED) {
+      if (it == golden.end()) fprintf(stderr, "Mode %u frame %u: %016llx, not in the golden file\n", h.mode, h.frame, h.hash);
+      else fprintf(stderr, "Mode %u frame %u: %016llx, golden %016llx\n", h.mode, h.frame, h.hash, it->second);
+    }
+  }
+  if (mismatches > 0) {
+    fprintf(stderr, "%lu of %zu frames differ from %s\n", mismatches, hashes.size(), goldenPath);
+    return 1;
+  }
+  fprintf(stderr, "All %zu frames match %s\n", hashes.size(), goldenPath);
+  return 0;
+}
@@ -0,0 +1,327 @@
+/**
+ * @file simulator.cpp
+ * @brief Simulation of the device on the host
+ *
+ * Host tool that runs the real sketch, setup() and loop(), on the virtual clock of the
+ * host builds (see Arduino.h), with the microphone playing a recording or the synthetic
+ * audio (at 16 kHz of the virtual clock, the sound between two captures is missed as on
+ * the device) and the P button playing a script. The display is the headless framebuffer and
+ * Serial (the debug mode text and the binary streams) goes to stdout or a file.
+ *
+ * Deep sleep is simulated as on the device: RAM is lost and the next boot runs setup()
+ * again. Each boot runs in a child process forked from the untouched program, so every
+ * global and static starts from its initial value; the event log keeps its file (-l, by
+ * default EVENT_LOG_HOST_PATH in a temporary directory) like the flash partition. While asleep the microphone keeps playing and the device wakes up when
+ * it drives its pin HIGH (the EXT0 wake-up of goToSleep()).
+ *
+ * The button script has one change per line, a time in seconds and press, release or
+ * click (a 100 ms press):
+ *
+ *   # Enter the tool modes and go to the next one.
+ *   1.0 click
+ *   4.0 click
+ *
+ * It is also the replay driver of the detection latency (see latencyStats.h): with a label
+ * file (-g), one ground truth tone onset per line in seconds of the recording, each onset
+ * is reported with latencyOnset() when the microphone plays it, on the virtual clock, and
+ * the time to the alert on the display goes to LAT_ONSET. Each boot also keeps every latency
+ * it measures, not only the window of LAT_ONSET, and at the end the simulation prints the
+ * onsets detected and the min, average and p99 latency of all the boots:
+ *
+ *   # Doorbell presses.
+ *   2.50
+ *   7.25
+ *
+ * Build: g++ -std=gnu++17 -O2 -DHEADLESS_DISPLAY -Ihost -I. -o simulator host/simulator.cpp host/hostInput.cpp host/arduinoHost.cpp fft.cpp
+ * Usage: simulator [-w audio.wav | -c audio.csv] [-b button script] [-p click seconds] [-t seconds] [-g onset labels] [-o serial output] [-l event log file] [-d dump directory]
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#include <algorithm>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../soundAlert-soundAnalyzer-ESP32.ino"
+
+/**
+ * @brief Default simulated time without a recording, in seconds.
+ */
+const double SIM_SECONDS = 60;
+
+/**
+ * @brief ADC value at which the microphone pin reads HIGH and wakes the device up.
+ */
+const int SIM_WAKE_LEVEL = 3000;
+
+/**
+ * @brief Time of a microphone sample, in nanoseconds.
+ */
+const unsigned long long SIM_SAMPLE_NANOS = 62500;
+
+/**
+ * @brief Press time of a click (-p), in ms.
+ */
+const unsigned long SIM_CLICK_MS = 100;
+
+/**
+ * @brief State a boot hands back to the simulation.
+ */
+struct BootReport {
+  unsigned long long nanos; /**< Virtual time at the end of the boot. */
+  unsigned long loops; /**< Calls to loop(). */
+  unsigned long frames; /**< Calls to display(). */
+  size_t nextLabel; /**< First onset label not reported yet. */
+  unsigned long detected; /**< Labelled onsets detected, their latencies (us) follow the report in the pipe. */
+  bool slept; /**< True if the boot ended in deep sleep, false at the end of the time. */
+};
+
+int reportPipe = -1; /**< Write end of the pipe to the simulation, in the boot process. */
+BootReport report; /**< Report of the boot process. */
+std::vector<double> onsetLabels; /**< Ground truth tone onsets, in seconds, sorted. */
+HostMicSource labelledSource = nullptr; /**< Microphone under the onset labels. */
+std::vector<unsigned long> onsetLatencies; /**< Onset to alert latencies of the boot process, in us. */
+unsigned short onsetNext = 0; /**< LAT_ONSET slot of the next latency to collect. */
+
+/**
+ * @brief Loads the onset labels, one time in seconds per line. Lines starting with # are
+ * comments and the rest of a line after the time is ignored.
+ * @param path Path of the labels.
+ * @return False if the file can't be read or a line is not valid.
+ */
+bool loadOnsetLabels(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == nullptr) return false;
+  char line[128];
+  bool valid = true;
+  while (valid and fgets(line, sizeof(line), file) != nullptr) {
+    char *p = line;
+    while (*p == ' ' or *p == '\t') p++;
+    if (*p == '#' or *p == '\n' or *p == '\r' or *p == '\0') continue;
+    char *end;
+    double seconds = strtod(p, &end);
+    valid = end != p and seconds >= 0;
+    if (valid) onsetLabels.push_back(seconds);
+  }
+  fclose(file);
+  std::sort(onsetLabels.begin(), onsetLabels.end());
+  return valid;
+}
+
+/**
+ * @brief Microphone source that reports the labelled onsets it plays with latencyOnset().
+ * @param n Index of the sample, at 16 kHz.
+ * @return ADC value of the labelled source.
+ */
+int labelledSample(unsigned long n) {
+  while (report.nextLabel < onsetLabels.size() and onsetLabels[report.nextLabel] * 1e9 <= n * SIM_SAMPLE_NANOS) {
+    latencyOnset(onsetLabels[report.nextLabel] * 1e6); // A missed onset is replaced by the next one.
+    report.nextLabel++;
+  }
+  return labelledSource(n);
+}
+
+/**
+ * @brief Collects the onset latency added to LAT_ONSET since the last call, if any. A loop
+ * renders one alert at most, so it must be called after each loop().
+ */
+void collectOnsetLatency() {
+  const LatencyStats &stats = latency::stats[LAT_ONSET];
+  if (stats.next == onsetNext) return;
+  onsetLatencies.push_back(stats.samples[(stats.next + LATENCY_WINDOW - 1) % LATENCY_WINDOW]);
+  onsetNext = stats.next;
+}
+
+/**
+ * @brief Writes a whole buffer to a pipe.
+ * @param fd The pipe.
+ * @param data The buffer.
+ * @param size Bytes of the buffer.
+ * @return False if the pipe is closed.
+ */
+bool writeAll(int fd, const void *data, size_t size) {
+  const char *p = (const char *)data;
+  while (size > 0) {
+    ssize_t n = write(fd, p, size);
+    if (n <= 0) return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+/**
+ * @brief Reads a whole buffer from a pipe.
+ * @param fd The pipe.
+ * @param data Output buffer.
+ * @param size Bytes to read.
+ * @return False if the pipe ends before.
+ */
+bool readAll(int fd, void *data, size_t size) {
+  char *p = (char *)data;
+  while (size > 0) {
+    ssize_t n = read(fd, p, size);
+    if (n <= 0) return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+/**
+ * @brief Sends the report of the boot and its onset latencies, and ends its process.
+ * @param slept True if the boot ended in deep sleep.
+ */
+void endBoot(bool slept) {
+  Serial.flush();
+  collectOnsetLatency();
+  report.nanos = hostNanos;
+  report.frames = display.frameCount();
+  report.detected = onsetLatencies.size();
+  report.slept = slept;
+  bool sent = writeAll(reportPipe, &report, sizeof(report))
+    and writeAll(reportPipe, onsetLatencies.data(), onsetLatencies.size() * sizeof(unsigned long));
+  _exit(sent ? 0 : 1);
+}
+
+/**
+ * @brief Deep sleep of the boot process.
+ */
+void simulatedDeepSleep() {
+  endBoot(true);
+}
+
+/**
+ * @brief Runs a boot of the device in a child process.
+ * @param nanos Virtual time of the wake-up.
+ * @param nextLabel First onset label not reported yet.
+ * @param end Virtual time at which the simulation ends.
+ * @param dumpPattern printf pattern of the frame dumps, nullptr to disable.
+ * @param result Output: the report of the boot.
+ * @param latencies Output: the onset latencies of the boot are appended, in us.
+ * @return False if the boot process failed.
+ */
+bool runBoot(unsigned long long nanos, size_t nextLabel, unsigned long long end, const char *dumpPattern, BootReport &result,
+             std::vector<unsigned long> &latencies) {
+  int fds[2];
+  if (pipe(fds) != 0) return false;
+  fflush(nullptr); // The child would write the buffered output again.
+  pid_t pid = fork();
+  if (pid < 0) return false;
+  if (pid == 0) {
+    close(fds[0]);
+    reportPipe = fds[1];
+    hostNanos = nanos;
+    report.nextLabel = nextLabel;
+    hostDeepSleep = simulatedDeepSleep;
+    display.dumpFrames(dumpPattern);
+    setup();
+    while (hostNanos < end) {
+      loop();
+      collectOnsetLatency();
+      report.loops++;
+    }
+    endBoot(false);
+  }
+
+  close(fds[1]);
+  bool received = readAll(fds[0], &result, sizeof(result));
+  if (received) {
+    size_t from = latencies.size();
+    latencies.resize(from + result.detected);
+    received = readAll(fds[0], latencies.data() + from, result.detected * sizeof(unsigned long));
+  }
+  close(fds[0]);
+  int status;
+  waitpid(pid, &status, 0);
+  return received and WIFEXITED(status) and WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char *argv[]) {
+  const char *serialPath = nullptr;
+  const char *dumpDir = nullptr;
+  double seconds = 0;
+  for (int i = 1; i < argc; i++) {
+    bool loaded = true;
+    if (strcmp(argv[i], "-w") == 0 and i + 1 < argc) loaded = hostLoadWav(argv[++i]);
+    else if (strcmp(argv[i], "-c") == 0 and i + 1 < argc) loaded = hostLoadCsv(argv[++i]);
+    else if (strcmp(argv[i], "-b") == 0 and i + 1 < argc) loaded = hostLoadButtonScript(argv[++i]);
+    else if (strcmp(argv[i], "-p") == 0 and i + 1 < argc) {
+      unsigned long ms = atof(argv[++i]) * 1000;
+      hostScheduleButton(ms, LOW);
+      hostScheduleButton(ms + SIM_CLICK_MS, HIGH);
+    } else if (strcmp(argv[i], "-t") == 0 and i + 1 < argc) seconds = atof(argv[++i]);
+    else if (strcmp(argv[i], "-g") == 0 and i + 1 < argc) loaded = loadOnsetLabels(argv[++i]);
+    else if (strcmp(argv[i], "-o") == 0 and i + 1 < argc) serialPath = argv[++i];
+    else if (strcmp(argv[i], "-l") == 0 and i + 1 < argc) eventLogStorage.setPath(argv[++i]);
+    else if (strcmp(argv[i], "-d") == 0 and i + 1 < argc) dumpDir = argv[++i];
+    else {
+      fprintf(stderr, "Usage: %s [-w audio.wav | -c audio.csv] [-b button script] [-p click seconds] [-t seconds] [-g onset labels] [-o serial output] [-l event log file] [-d dump directory]\n", argv[0]);
+      return 2;
+    }
+    if (!loaded) {
+      fprintf(stderr, "Can't load %s\n", argv[i]);
+      return 2;
+    }
+  }
+
+  if (hostRecordedSamples() > 0) {
+    hostMicSource = hostRecordedSample;
+    if (seconds <= 0) seconds = (double)hostRecordedSamples() / 16000;
+  }
+  if (seconds <= 0) seconds = SIM_SECONDS;
+  if (!onsetLabels.empty()) {
+    labelledSource = hostMicSource;
+    hostMicSource = labelledSample;
+  }
+  hostButtonSource = hostScriptedButton;
+  hostMicClocked = true; // The recording plays in virtual time, also between the captures.
+  if (serialPath != nullptr) {
+    hostSerialOut = fopen(serialPath, "wb");
+    if (hostSerialOut == nullptr) {
+      fprintf(stderr, "Can't write %s\n", serialPath);
+      return 1;
+    }
+  }
+
+  unsigned long long end = seconds * 1e9;
+  unsigned long long nanos = 0;
+  unsigned long totalLoops = 0, totalFrames = 0;
+  size_t nextLabel = 0;
+  std::vector<unsigned long> latencies; // Onset to alert, in us, of all the boots.
+  char dumpPattern[256];
+  for (unsigned short boot = 0; nanos < end; boot++) {
+    if (dumpDir != nullptr) snprintf(dumpPattern, sizeof(dumpPattern), "%s/boot%03u_frame%%05lu.pbm", dumpDir, boot);
+    BootReport result;
+    if (!runBoot(nanos, nextLabel, end, dumpDir != nullptr ? dumpPattern : nullptr, result, latencies)) {
+      fprintf(stderr, "Boot %u failed\n", boot);
+      return 1;
+    }
+    fprintf(stderr, "Boot %u: awake %.3f - %.3f s, %lu loops, %lu frames%s\n", boot, nanos / 1e9, result.nanos / 1e9,
+            result.loops, result.frames, result.slept ? ", deep sleep" : "");
+    totalLoops += result.loops;
+    totalFrames += result.frames;
+    nextLabel = result.nextLabel;
+    if (!result.slept) break;
+
+    // Asleep, the microphone keeps playing until it wakes the device up.
+    nanos = result.nanos;
+    while (nanos < end and hostMicSource(nanos / SIM_SAMPLE_NANOS) < SIM_WAKE_LEVEL) nanos += SIM_SAMPLE_NANOS;
+  }
+  fprintf(stderr, "%.3f s simulated, %lu loops, %lu frames\n", end / 1e9, totalLoops, totalFrames);
+  if (!onsetLabels.empty()) {
+    fprintf(stderr, "Onsets: %zu labelled, %zu played, %zu detected\n", onsetLabels.size(), nextLabel, latencies.size());
+    if (!latencies.empty()) {
+      std::sort(latencies.begin(), latencies.end());
+      unsigned long long sum = 0;
+      for (unsigned long us : latencies) sum += us;
+      size_t k = (latencies.size() * 99 + 99) / 100 - 1; // ceil(0.99 * count) - 1, as LatencyStats
+      fprintf(stderr, "%-8s %7lu %7llu %7lu us (min, avg, p99)\n", LATENCY_STAGE_NAMES[LAT_ONSET], latencies.front(),
+              sum / latencies.size(), latencies[k]);
+    }
+  }
+  if (serialPath != nullptr) fclose(hostSerialOut);
+  return 0;
+}
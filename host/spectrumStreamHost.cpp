@@ -0,0 +1,67 @@
+/**
+ * @file spectrumStreamHost.cpp
+ * @brief Spectrum stream of the host build
+ *
+ * Host tool that runs the Spectrum Stream mode on the synthetic audio of the host builds
+ * (see Arduino.h) and writes the Serial output to a file, a pseudo-terminal or stdout, so
+ * tools/spectrumStreamDecoder.cpp can be tested without the device:
+ *
+ *   socat -d -d pty,raw,echo=0 pty,raw,echo=0     (prints the two ends, e.g. /dev/pts/3 and /dev/pts/4)
+ *   spectrumStreamHost -p -o /dev/pts/3
+ *   spectrumStreamDecoder -o spectrogram.pgm /dev/pts/4
+ *
+ * Build: g++ -std=gnu++17 -O2 -DHEADLESS_DISPLAY -Ihost -I. -o spectrumStreamHost host/spectrumStreamHost.cpp host/arduinoHost.cpp fft.cpp
+ * Usage: spectrumStreamHost [-n captures] [-o output] [-p]
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#include <unistd.h>
+
+#include "../soundAlert-soundAnalyzer-ESP32.ino"
+
+/**
+ * @brief Default number of captures.
+ */
+const unsigned long STREAM_CAPTURES = 1000;
+
+int main(int argc, char *argv[]) {
+  const char *outputPath = nullptr;
+  unsigned long captures = STREAM_CAPTURES;
+  bool paced = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-n") == 0 and i + 1 < argc) captures = atol(argv[++i]);
+    else if (strcmp(argv[i], "-o") == 0 and i + 1 < argc) outputPath = argv[++i];
+    else if (strcmp(argv[i], "-p") == 0) paced = true;
+    else {
+      fprintf(stderr, "Usage: %s [-n captures] [-o output] [-p (real time)]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (outputPath != nullptr) {
+    hostSerialOut = fopen(outputPath, "wb");
+    if (hostSerialOut == nullptr) {
+      fprintf(stderr, "Can't write %s\n", outputPath);
+      return 1;
+    }
+  }
+
+  currentMode = -1;
+  for (short i = 0; i < MAXMODES; i++) {
+    if (MODES[i].step == stepModeState<SpectrumStreamState, displaySpectrumStream>) currentMode = i;
+  }
+  initSoundAnalysisTools();
+  initAlerts();
+  changeMode = true;
+  for (unsigned long n = 0; n < captures; n++) {
+    unsigned long long start = hostNanos;
+    scheduler.service();
+    selectDisplayMode();
+    changeMode = false;
+    Serial.flush();
+    if (paced) usleep((hostNanos - start) / 1000); // As fast as the device.
+  }
+  if (outputPath != nullptr) fclose(hostSerialOut);
+  return 0;
+}
@@ -0,0 +1,208 @@
+/**
+ * @file latencyStats.h
+ * @brief Detection latency instrumentation
+ *
+ * This file contains the instrumentation of the listening pipeline. Each stage of a frame
+ * (capture, window, FFT, peak search, alert matching and render) is timestamped with
+ * micros() and its duration is added to rolling statistics (min, average and p99 of the
+ * last LATENCY_WINDOW frames) kept in fixed-size arrays.
+ *
+ * In replay mode (the simulation with onset labels, see host/simulator.cpp) the driver
+ * reports the ground truth onset of each tone with latencyOnset() on the virtual clock,
+ * and the time from that onset to the alert on the display is added to the LAT_ONSET
+ * statistics.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include <algorithm>
+
+// ---------- Constants --------------
+/**
+ * @brief Stages of a listening frame.
+ */
+typedef enum {
+  LAT_CAPTURE,      ///< Sound capture (capture start to capture end)
+  LAT_WINDOW,       ///< Window function
+  LAT_FFT,          ///< FFT
+  LAT_PEAK,         ///< Peak search, spectral features, pitch and averaged power spectrum
+  LAT_MATCH,        ///< Alert and sequence matching
+  LAT_RENDER,       ///< Alert render, only frames with an alert
+  LAT_FRAME,        ///< Whole frame, capture start to the end of the frame
+  LAT_ONSET,        ///< Ground truth tone onset to alert rendered (replay mode)
+  N_LATENCY_STAGES
+} LatencyStage;
+
+/**
+ * @brief Names of the stages, in LatencyStage order.
+ */
+const char *const LATENCY_STAGE_NAMES[N_LATENCY_STAGES] = {
+  "capture", "window", "fft", "peak", "match", "render", "frame", "onset"
+};
+
+/**
+ * @brief Number of frames of the rolling statistics. p99 needs at least 100.
+ */
+const unsigned short LATENCY_WINDOW = 128;
+
+/**
+ * @brief Frames between two reports in debug mode.
+ */
+const unsigned short LATENCY_REPORT_FRAMES = 256;
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Rolling statistics of the last LATENCY_WINDOW durations of a stage.
+ */
+struct LatencyStats {
+  unsigned long samples[LATENCY_WINDOW]; /**< Last durations in us, circular. */
+  unsigned short count; /**< Number of valid samples. */
+  unsigned short next; /**< Next sample to overwrite. */
+  unsigned long long sum; /**< Sum of the valid samples. */
+
+  /**
+   * @brief Adds a duration, replacing the oldest one if the window is full.
+   * @param us Duration in microseconds.
+   */
+  void add(unsigned long us) {
+    if (count == LATENCY_WINDOW) sum -= samples[next];
+    else count++;
+    samples[next] = us;
+    sum += us;
+    next = (next + 1) % LATENCY_WINDOW;
+  }
+
+  /**
+   * @brief Gets the minimum of the window.
+   * @return Minimum duration in us, 0 if empty.
+   */
+  unsigned long minimum() const {
+    if (count == 0) return 0;
+    unsigned long m = samples[0];
+    for (unsigned short i = 1; i < count; i++) m = min(m, samples[i]);
+    return m;
+  }
+
+  /**
+   * @brief Gets the average of the window.
+   * @return Average duration in us, 0 if empty.
+   */
+  unsigned long average() const {
+    if (count == 0) return 0;
+    return sum / count;
+  }
+
+  /**
+   * @brief Gets the 99th percentile of the window.
+   * @return p99 duration in us, 0 if empty.
+   */
+  unsigned long percentile99() const {
+    static unsigned long sorted[LATENCY_WINDOW];
+    if (count == 0) return 0;
+    unsigned short k = (count * 99 + 99) / 100 - 1; // ceil(0.99 * count) - 1
+    std::copy(samples, samples + count, sorted);
+    std::nth_element(sorted, sorted + k, sorted + count);
+    return sorted[k];
+  }
+};
+
+/**
+ * @namespace latency
+ * @brief Namespace for the latency instrumentation state.
+ */
+namespace latency {
+  LatencyStats stats[N_LATENCY_STAGES]; /**< Statistics of each stage. */
+  unsigned long frameStart; /**< micros() at capture start. */
+  unsigned long lastMark; /**< micros() at the end of the previous stage. */
+  unsigned long onset; /**< Ground truth onset (micros()) of the tone being detected. */
+  bool onsetPending = false; /**< True until the onset is detected. */
+  unsigned short frames = 0; /**< Frames since the last report. */
+}
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Starts a frame. Called at capture start.
+ */
+void latencyFrameStart();
+
+/**
+ * @brief Ends a stage: adds the time since the previous mark to its statistics.
+ * @param stage The stage that has just finished.
+ */
+void latencyMark(LatencyStage stage);
+
+/**
+ * @brief Ends the frame: adds the time since capture start to LAT_FRAME.
+ */
+void latencyFrameEnd();
+
+/**
+ * @brief Reports the ground truth onset of a tone (replay mode).
+ * @param us Onset time in the micros() clock.
+ */
+void latencyOnset(unsigned long us);
+
+/**
+ * @brief Reports that an alert has been rendered. Closes the pending onset, if any.
+ */
+void latencyAlert();
+
+/**
+ * @brief Prints min/avg/p99 of every stage.
+ * @param out Output stream, usually Serial.
+ */
+void printLatencyStats(Print &out);
+
+/**
+ * @brief Prints the statistics every LATENCY_REPORT_FRAMES frames.
+ * @param out Output stream, usually Serial.
+ */
+void reportLatency(Print &out);
+
+// ---------- Code --------------
+void latencyFrameStart() {
+  latency::frameStart = micros();
+  latency::lastMark = latency::frameStart;
+}
+
+void latencyMark(LatencyStage stage) {
+  unsigned long now = micros();
+  latency::stats[stage].add(now - latency::lastMark);
+  latency::lastMark = now;
+}
+
+void latencyFrameEnd() {
+  latency::stats[LAT_FRAME].add(micros() - latency::frameStart);
+}
+
+void latencyOnset(unsigned long us) {
+  latency::onset = us;
+  latency::onsetPending = true;
+}
+
+void latencyAlert() {
+  if (!latency::onsetPending) return;
+  latency::stats[LAT_ONSET].add(micros() - latency::onset);
+  latency::onsetPending = false;
+}
+
+void printLatencyStats(Print &out) {
+  char line[48];
+  out.println(F("stage     min_us  avg_us  p99_us"));
+  for (unsigned char i = 0; i < N_LATENCY_STAGES; i++) {
+    const LatencyStats &s = latency::stats[i];
+    if (s.count == 0) continue;
+    snprintf(line, sizeof(line), "%-8s %7lu %7lu %7lu", LATENCY_STAGE_NAMES[i], s.minimum(), s.average(), s.percentile99());
+    out.println(line);
+  }
+}
+
+void reportLatency(Print &out) {
+  if (++latency::frames < LATENCY_REPORT_FRAMES) return;
+  latency::frames = 0;
+  printLatencyStats(out);
+}
@@ -14,7 +14,17 @@
 #include "board.h"
 #include "display.h"
 #include "soundInfo.h"
+#include "eventLog.h"
 #include "pair.h"
+#include "cycleTelemetry.h"
+
+/**
+ * @namespace alertWatch
+ * @brief Namespace for the state of the alert matching.
+ */
+namespace alertWatch {
+  bool active = false; /**< True while an alert or a sequence is matched. */
+}
 
 
 // ----------------- Main listening mode -----------------
@@ -40,10 +50,11 @@ void listen(short mode, bool debug, unsigned long &lastActivity, int &awakeDurat
 void printListeningLogo();
 
 /**
-* @brief Draws the alert images on the display for a given AlertElement.
-* @param a The AlertElement containing the image properties.
+* @brief Draws the alert images on the display for a given AlertElement or SequenceElement.
+* @param a The element containing the image properties.
 */
-void drawAlertImages(AlertElement &a);
+template <class T>
+void drawAlertImages(T &a);
 
 /**
 * @brief Displays the alert information on the display.
@@ -55,8 +66,10 @@ void printAlert(bool debug);
 /**
  * @brief Checks if there is a match between the analyzed sound data and the defined alerts.
  *
- * This function checks if the maximum intensity and its corresponding index
- * match any of the defined alerts.
+ * This function checks if the maximum intensity and its corresponding index (or the
+ * pitch, see frequencyMatching()) match any of the defined alerts, and if the spectrum of the frame is tonal enough
+ * (its spectral flatness, see spectralFeatures.h). An averaged alert takes the peak of the
+ * averaged power spectrum of the bus instead (see psdAverage.h).
  *
  * @param maxA The maximum intensity value.
  * @param maxI The index of the maximum intensity value.
@@ -64,6 +77,93 @@ void printAlert(bool debug);
  */
 bool alertMatching(const float maxA, const int maxI);
 
+/**
+ * @brief Checks if the frequency of the frame matches an alert or a tone of a sequence.
+ *
+ * With a pitch tolerance, the pitch of the frame (see pitchDetector.h) must be that close
+ * to the frequency of the element, so a harmonic in its range doesn't match. Otherwise the
+ * peak bin must be in the iterator range.
+ *
+ * @param t The AlertElement or ToneStep.
+ * @param maxI The index of the maximum intensity value.
+ * @return True if the frequency matches.
+ */
+template <class T>
+bool frequencyMatching(const T &t, const int maxI);
+
+/**
+ * @brief Gets the peak an alert or a tone of a sequence is matched against.
+ *
+ * @param t The AlertElement or ToneStep.
+ * @param maxA The maximum intensity value.
+ * @param maxI The index of the maximum intensity value.
+ * @return The frame peak, or the peak of the averaged power spectrum if t is averaged.
+ */
+template <class T>
+Pair<float, int> matchedPeak(const T &t, const float maxA, const int maxI);
+
+/**
+ * @brief Gets the minimum intensity of the peak of an alert or a tone of a sequence.
+ *
+ * The frame peak is the real part of its bin and the averaged peak a magnitude, so each
+ * has its own threshold.
+ *
+ * @param t The AlertElement or ToneStep.
+ * @return minAverageIntensity if t is averaged, minIntensity otherwise.
+ */
+template <class T>
+int matchedMinimum(const T &t);
+
+/**
+ * @brief Checks if the frame peak matches a tone of a sequence.
+ *
+ * @param t The tone.
+ * @param maxA The maximum intensity value.
+ * @param maxI The index of the maximum intensity value.
+ * @return True if the frequency of its peak (see matchedPeak()) matches (see
+ * frequencyMatching()) with enough intensity and the spectrum of the frame is tonal enough.
+ */
+bool toneMatching(const ToneStep &t, const float maxA, const int maxI);
+
+/**
+ * @brief Feeds the frame peak to the automaton of every sequence.
+ *
+ * Each automaton advances when the peak matches its next tone, stays while the current
+ * tone is still sounding, and restarts when the gap to the next tone exceeds maxGap.
+ * Constant state and cost per sequence.
+ *
+ * @param maxA The maximum intensity value.
+ * @param maxI The index of the maximum intensity value.
+ * @param now The current time in ms.
+ * @return True if a sequence has just been completed.
+ */
+bool sequenceMatching(const float maxA, const int maxI, const unsigned long now);
+
+/**
+ * @brief Clears the status of the sequence alerts.
+ */
+void clearSequenceAlerts();
+
+/**
+ * @brief Matches the frame peak against the alerts and the sequences and logs the onsets.
+ *
+ * Used by the listening mode and, on the same capture as the display, by the tool modes.
+ *
+ * @param maxA The maximum intensity value.
+ * @param maxI The index of the maximum intensity value.
+ * @param onset Output: true if an alert has just started.
+ * @return True while an alert is active.
+ */
+bool watchAlerts(const float maxA, const int maxI, bool &onset);
+
+/**
+ * @brief Logs the alert that has just fired in the event log.
+ *
+ * @param maxA The maximum intensity value.
+ * @param maxI The index of the maximum intensity value.
+ */
+void logAlert(const float maxA, const int maxI);
+
 
 // ---------------- Printing images and info --------------------
 void printListeningLogo() {
@@ -74,7 +174,8 @@ void printListeningLogo() {
   display.display();
 }
 
-void drawAlertImages(AlertElement &a) {
+template <class T>
+void drawAlertImages(T &a) {
   display.drawXBitmap(
     a.image1_xPos,
     a.image1_yPos,
@@ -94,19 +195,31 @@ void drawAlertImages(AlertElement &a) {
 }
 
 void printAlert(bool debug) {
+  bool sequenceAlert = false;
+  for (short i = 0; i < N_SEQUENCE_TYPES; i++) sequenceAlert = sequenceAlert or sequences[i].alertStatus;
+
   display.clearDisplay();
-  if (debug) {
+  if (sequenceAlert) { // A sequence is more specific than its single tones.
+    for (short i = 0; i < N_SEQUENCE_TYPES; i++) {
+      if (!sequences[i].alertStatus) continue;
+      if (debug) {
+        TextLine text;
+        display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+        drawText(0, 0, text.add("Sequence! ").addInt(i).c_str());
+        for (short j = 0; j < sequences[i].nSteps and j < 3; j++) {
+          drawText(0, FONT_HEIGHT * (j + 1), text.clear().add("Hz: ").addInt(sequences[i].steps[j].freq).c_str());
+        }
+      } else drawAlertImages(sequences[i]);
+    }
+  } else if (debug) {
     display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);  
     for (short i = 0; i < N_ALERT_TYPES; i++) {
       if (alerts[i].alertStatus) {
-        display.setCursor(0, 0);
-        display.println("Alert! " + String(i));
-        display.setCursor(0, FONT_HEIGHT);
-        display.println("Hz: " + String(alerts[i].freq));
-        display.setCursor(0, FONT_HEIGHT * 2);
-        display.println("Mark: " + String(alerts[i].iteratorRangeMin) + " >=< " + String(alerts[i].iteratorRangeMax));
-        display.setCursor(0, FONT_HEIGHT * 3);
-        display.println("Intensity: " + String(alerts[i].intensityMark));
+        TextLine text;
+        drawText(0, 0, text.add("Alert! ").addInt(i).c_str());
+        drawText(0, FONT_HEIGHT, text.clear().add("Hz: ").addInt(alerts[i].freq).c_str());
+        drawText(0, FONT_HEIGHT * 2, text.clear().add("Mark: ").addInt(alerts[i].iteratorRangeMin).add(" >=< ").addInt(alerts[i].iteratorRangeMax).c_str());
+        drawText(0, FONT_HEIGHT * 3, text.clear().add("Intensity: ").addInt(alerts[i].intensityMark).c_str());
       }
     }  
   } else {
@@ -122,10 +235,12 @@ void printAlert(bool debug) {
 bool alertMatching(const float maxA, const int maxI) {
   bool alertMatch = false;
   for (short i = 0; i < N_ALERT_TYPES; i++) {
-    if (maxI >= alerts[i].iteratorRangeMin and maxI <= alerts[i].iteratorRangeMax and maxA > alerts[i].minIntensity){
+    Pair<float, int> peak = matchedPeak(alerts[i], maxA, maxI);
+    if (frequencyMatching(alerts[i], peak.second) and peak.first > matchedMinimum(alerts[i])
+        and spectrumBus::frame.features.flatness <= alerts[i].maxFlatness){
       alertMatch = true;
       alerts[i].alertStatus = true; 
-      alerts[i].intensityMark = maxA;
+      alerts[i].intensityMark = peak.first;
       for (int j = 0; j < N_ALERT_TYPES; j++) { // Clear other alert match
         if (j != i) alerts[j].alertStatus = false;
       }      
@@ -134,19 +249,106 @@ bool alertMatching(const float maxA, const int maxI) {
   return alertMatch;
 }
 
+template <class T>
+bool frequencyMatching(const T &t, const int maxI) {
+  if (t.pitchTolerance > 0) {
+    const PitchEstimate &pitch = spectrumBus::frame.pitch;
+    return pitch.voiced and fabsf(pitch.hz - t.freq) <= t.pitchTolerance;
+  }
+  return maxI >= t.iteratorRangeMin and maxI <= t.iteratorRangeMax;
+}
+
+template <class T>
+Pair<float, int> matchedPeak(const T &t, const float maxA, const int maxI) {
+  if (t.averaged) return {spectrumBus::frame.averageA, spectrumBus::frame.averageI};
+  return {maxA, maxI};
+}
+
+template <class T>
+int matchedMinimum(const T &t) {
+  return t.averaged ? t.minAverageIntensity : t.minIntensity;
+}
+
+bool toneMatching(const ToneStep &t, const float maxA, const int maxI) {
+  Pair<float, int> peak = matchedPeak(t, maxA, maxI);
+  return frequencyMatching(t, peak.second) and peak.first > matchedMinimum(t)
+    and spectrumBus::frame.features.flatness <= t.maxFlatness;
+}
+
+bool sequenceMatching(const float maxA, const int maxI, const unsigned long now) {
+  bool sequenceMatch = false;
+  for (short i = 0; i < N_SEQUENCE_TYPES; i++) {
+    SequenceElement &s = sequences[i];
+    if (s.step > 0 and now - s.lastSeen > s.maxGap) s.step = 0; // Too late for the next tone.
+
+    if (s.step > 0 and toneMatching(s.steps[s.step - 1], maxA, maxI)) {
+      s.lastSeen = now; // Current tone still sounding.
+    } else if (toneMatching(s.steps[s.step], maxA, maxI)) {
+      s.step++;
+      s.lastSeen = now;
+    } else if (s.step > 0 and toneMatching(s.steps[0], maxA, maxI)) {
+      s.step = 1; // Out of order, may be the start of a new sequence.
+      s.lastSeen = now;
+    }
+
+    if (s.step == s.nSteps) {
+      sequenceMatch = true;
+      s.step = 0;
+      s.intensityMark = maxA;
+      for (short j = 0; j < N_SEQUENCE_TYPES; j++) sequences[j].alertStatus = (j == i);
+    }
+  }
+  return sequenceMatch;
+}
+
+void clearSequenceAlerts() {
+  for (short i = 0; i < N_SEQUENCE_TYPES; i++) sequences[i].alertStatus = false;
+}
+
+void logAlert(const float maxA, const int maxI) {
+  int snr = 0;
+  if (meanA > 0 and maxA > 0) snr = round(20.0f * log10f(maxA / meanA));
+  for (short i = 0; i < N_SEQUENCE_TYPES; i++) { // Sequences are logged after the single alerts ids.
+    if (sequences[i].alertStatus) {
+      logDetection(N_ALERT_TYPES + i, maxI, maxA, snr);
+      return;
+    }
+  }
+  for (short i = 0; i < N_ALERT_TYPES; i++) {
+    if (alerts[i].alertStatus) logDetection(i, maxI, maxA, snr);
+  }
+}
+
+
+bool watchAlerts(const float maxA, const int maxI, bool &onset) {
+  bool prevAlert = alertWatch::active;
+  CYCLE_BEGIN(CYC_MATCH);
+  bool alert = alertMatching(maxA, maxI);
+  if (alert and !prevAlert) clearSequenceAlerts(); // A new tone, show it unless it completes a sequence.
+  bool sequenceAlert = sequenceMatching(maxA, maxI, millis());
+  CYCLE_END(CYC_MATCH);
+  onset = (alert and !prevAlert) or sequenceAlert;
+  if (onset) logAlert(maxA, maxI); // Only the onset of the alert.
+  alertWatch::active = alert or sequenceAlert;
+  latencyMark(LAT_MATCH);
+  return alertWatch::active;
+}
+
 
 // ----------------- Main listening mode -----------------
 void listen(short mode, bool debug, unsigned long &lastActivity, int &awakeDuration) {
-  static bool alert = false;
-  
-  if (!alert and mode != -1) printListeningLogo();  
+  if (!alertWatch::active and mode != -1) printListeningLogo();  
   
   Pair<float, int> maxVal = analyzeSound();
-  alert = alertMatching(maxVal.first, maxVal.second);
+  if (spectrumBus::frame.cancelled) return; // A click, the loop enters the tool modes.
+  bool onset;
+  bool alert = watchAlerts(maxVal.first, maxVal.second, onset);
   if (alert) {
     lastActivity = millis();
     awakeDuration = (2 * 60 * 1000); // 2 minutes showing alert
     printAlert(debug);
+    latencyMark(LAT_RENDER);
+    if (onset) latencyAlert();
     /* 
     * You can implement here a Wifi communication if it's considered necessary.
     * Think that you may need a communication queue with non-repeatable elements
@@ -155,7 +357,11 @@ void listen(short mode, bool debug, unsigned long &lastActivity, int &awakeDurat
   }
 
   // info in listening mode.
-  if (debug and !alert) showListeningInfo(0, maxVal.first, maxVal.second);
-  
+  if (debug and !alert) {
+    showListeningInfo(0, maxVal.first, maxVal.second);
+    display.display();
+  }
+  latencyFrameEnd();
+  if (debug) reportLatency(Serial);
 }
 
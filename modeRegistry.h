@@ -0,0 +1,157 @@
+/**
+ * @file modeRegistry.h
+ * @brief Table-driven registry of the display modes
+ *
+ * This file describes each tool mode as a DisplayMode entry: its title, the size of its
+ * state and its init, step and teardown callbacks. The modes are listed in one table, so
+ * adding a mode only adds an entry.
+ *
+ * Each step gets the last capture of the spectrum bus (see spectrumBus.h): the modes don't
+ * capture sound on their own.
+ *
+ * The state of the active mode lives in a single arena sized for the largest mode. It is
+ * constructed (zeroed) when the mode is entered and destroyed when the mode is left, so
+ * the buffers of the modes that aren't shown don't take RAM.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <new>
+#include "spectrumBus.h"
+
+// ---------- Constants --------------
+/**
+ * @brief Lines of a mode title.
+ */
+const unsigned char MODE_TITLE_LINES = 2;
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Display mode: title, state size and callbacks.
+ */
+struct DisplayMode {
+  const char *title[MODE_TITLE_LINES]; /**< Title lines, nullptr if unused. */
+  size_t stateSize; /**< Bytes of the mode state. */
+  void (*init)(void *state); /**< Constructs the state and draws the fixed content. */
+  void (*step)(void *state, const BusFrame &frame); /**< Draws one capture of the bus. */
+  void (*teardown)(void *state); /**< Destroys the state. */
+};
+
+// ---------- Headers --------------
+/**
+ * @brief Constructs a mode state in the arena and initializes the mode.
+ * @tparam State State of the mode.
+ * @tparam Init Draws the fixed content and sets up the state.
+ * @param state The arena.
+ */
+template <typename State, void (*Init)(State &)>
+void initModeState(void *state) {
+  Init(*new (state) State());
+}
+
+/**
+ * @brief Runs a step of a mode.
+ * @tparam State State of the mode.
+ * @tparam Step Draws one capture of the bus.
+ * @param state The arena.
+ * @param frame The last capture.
+ */
+template <typename State, void (*Step)(State &, const BusFrame &)>
+void stepModeState(void *state, const BusFrame &frame) {
+  Step(*static_cast<State *>(state), frame);
+}
+
+/**
+ * @brief Destroys a mode state.
+ * @tparam State State of the mode.
+ * @param state The arena.
+ */
+template <typename State>
+void teardownModeState(void *state) {
+  static_cast<State *>(state)->~State();
+}
+
+/**
+ * @brief Describes a mode.
+ * @tparam State State of the mode, constructed zeroed on entry.
+ * @tparam Init Draws the fixed content and sets up the state.
+ * @tparam Step Draws one capture of the bus.
+ * @param line0 First title line, nullptr for none.
+ * @param line1 Second title line, nullptr for none.
+ * @return The mode table entry.
+ */
+template <typename State, void (*Init)(State &), void (*Step)(State &, const BusFrame &)>
+constexpr DisplayMode displayMode(const char *line0, const char *line1 = nullptr) {
+  static_assert(alignof(State) <= alignof(max_align_t), "Mode state over-aligned for the arena");
+  return DisplayMode{{line0, line1}, sizeof(State), initModeState<State, Init>, stepModeState<State, Step>, teardownModeState<State>};
+}
+
+/**
+ * @brief Gets the largest state of a mode table.
+ * @param modes The modes.
+ * @param n Number of modes.
+ * @param largest Largest state so far.
+ * @return Bytes of the largest state.
+ */
+constexpr size_t largestModeState(const DisplayMode *modes, size_t n, size_t largest = 0) {
+  return n == 0 ? largest : largestModeState(modes + 1, n - 1, modes[0].stateSize > largest ? modes[0].stateSize : largest);
+}
+
+// ---------- Class Definition --------------
+/**
+ * @brief Runs the active mode in an arena shared by all the modes.
+ * @tparam ArenaSize Bytes of the largest mode state.
+ */
+template <size_t ArenaSize>
+class ModeRunner {
+private:
+  alignas(max_align_t) unsigned char arena[ArenaSize]; /**< State of the active mode. */
+  const DisplayMode *active = nullptr; /**< Active mode, nullptr if none. */
+
+public:
+  /**
+   * @brief Leaves the active mode and enters a new one.
+   * @param mode The mode to enter.
+   */
+  void enter(const DisplayMode &mode) {
+    leave();
+    active = &mode;
+    mode.init(arena);
+  }
+
+  /**
+   * @brief Leaves the active mode, releasing its state.
+   */
+  void leave() {
+    if (active != nullptr) active->teardown(arena);
+    active = nullptr;
+  }
+
+  /**
+   * @brief Runs a step of the active mode.
+   * @param frame The last capture.
+   */
+  void step(const BusFrame &frame) {
+    if (active != nullptr) active->step(arena, frame);
+  }
+
+  /**
+   * @brief Gets the active mode.
+   * @return The active mode, nullptr if none.
+   */
+  const DisplayMode *current() const {
+    return active;
+  }
+
+  /**
+   * @brief Gets the bytes reserved for the mode states.
+   * @return Size of the arena.
+   */
+  static constexpr size_t arenaSize() {
+    return ArenaSize;
+  }
+};
@@ -0,0 +1,301 @@
+/**
+ * @file octaveBands.h
+ * @brief Octave and third-octave band analyzer modes
+ *
+ * This file contains the band analyzer modes: the energy of the spectrum in octave or
+ * third-octave bands, with base 2 centers at 1000 * 2^(k / bands per octave) Hz and edges
+ * half a band away. Unlike the spectrum bars, with the same width in Hz for every bar,
+ * each band is as wide as the ear hears it, so the low frequencies get as many bars as the
+ * high ones.
+ *
+ * A bin on the edge of two bands splits its energy between them by its overlap. The bin
+ * to band table (BandTable) is built once when the mode starts, for the FFT size of the
+ * bus, so each capture is summed in one pass over the bins: two multiply-adds per bin.
+ *
+ * Each bar is the Leq (energy average) of the captures since the last frame, with a
+ * peak-hold marker above it and the Leq since the mode started as an inverted line inside
+ * it. The header shows the Leq of all the bands since the mode started. The levels are in
+ * dB from the energy of a full-scale sine (dBFS).
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <math.h>
+#include <complex.h>
+#include "display.h"
+#include "textOverlay.h"
+#include "frameGovernor.h"
+#include "spectrumBus.h"
+#include "peakHold.h"
+
+// ---------- Constants --------------
+/**
+ * @brief Most bands of a table.
+ */
+const unsigned char BAND_MAX_BANDS = 24;
+
+/**
+ * @brief Most bins of a table.
+ */
+const unsigned short BAND_MAX_BINS = BUS_SAMPLES / 2;
+
+/**
+ * @brief Center of the lowest band (Hz), rounded to the nearest band.
+ */
+const float BAND_FROM_HZ = 100.0f;
+
+/**
+ * @brief Energy of a full-scale sine (ADC swing of 2048) in its band, Hamming window of
+ * BUS_SAMPLES (dB): 2048^2 * BUS_SAMPLES^2 * 0.0994.
+ */
+const float BAND_FULL_SCALE_DB = 116.4f;
+
+/**
+ * @brief Range of the graph below full scale (dB).
+ */
+const float BAND_RANGE_DB = 72.0f;
+
+/**
+ * @brief Frames a band peak is held.
+ */
+const unsigned char BAND_PEAK_HOLD = 16;
+
+/**
+ * @brief Pixels a band peak falls per frame.
+ */
+const unsigned char BAND_PEAK_DECAY = 1;
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Bin to band table of a FFT size.
+ *
+ * The energies are summed in slots: slot 0 takes the bins below the first band, slot
+ * b + 1 the band b and slot bands + 1 the bins above the last band.
+ */
+struct BandTable {
+  unsigned char slot[BAND_MAX_BINS]; /**< Slot of the lower part of each bin, the rest goes to the next slot. */
+  float weight[BAND_MAX_BINS]; /**< Fraction of each bin in its slot. */
+  short firstK; /**< Exponent of the center of the first band. */
+  unsigned char bands; /**< Number of bands. */
+  unsigned char perOctave; /**< Bands per octave. */
+  unsigned short bins; /**< Bins of the table. */
+
+  /**
+   * @brief Builds the table.
+   * @param bandsPerOctave 1 for octaves, 3 for third-octaves.
+   * @param nBins Bins up to the Nyquist frequency, BAND_MAX_BINS at most.
+   * @param hzPerBin Hz per bin.
+   */
+  void build(unsigned char bandsPerOctave, unsigned short nBins, float hzPerBin) {
+    perOctave = bandsPerOctave;
+    bins = min(nBins, BAND_MAX_BINS);
+    float nyquist = bins * hzPerBin;
+    firstK = round(perOctave * log2f(BAND_FROM_HZ / 1000.0f));
+    bands = 0;
+    while (bands < BAND_MAX_BANDS and upperEdge(bands) <= nyquist) bands++;
+
+    unsigned char b = 0; // Slot of the bin bottom.
+    for (unsigned short k = 0; k < bins; k++) {
+      float bottom = (k - 0.5f) * hzPerBin;
+      float top = (k + 0.5f) * hzPerBin;
+      while (b <= bands and (b == 0 ? lowerEdge(0) : upperEdge(b - 1)) <= bottom) b++;
+      float edge = b == 0 ? lowerEdge(0) : (b <= bands ? upperEdge(b - 1) : top);
+      slot[k] = k == 0 ? 0 : b; // DC out of every band.
+      weight[k] = k == 0 ? 1.0f : min(1.0f, (edge - bottom) / hzPerBin);
+    }
+  }
+
+  /**
+   * @brief Gets the center of a band.
+   * @param band The band.
+   * @return Center (Hz).
+   */
+  float center(unsigned char band) const {
+    return 1000.0f * exp2f((float)(firstK + band) / perOctave);
+  }
+
+  /**
+   * @brief Gets the lower edge of a band.
+   * @param band The band.
+   * @return Lower edge (Hz).
+   */
+  float lowerEdge(unsigned char band) const {
+    return center(band) * exp2f(-0.5f / perOctave);
+  }
+
+  /**
+   * @brief Gets the upper edge of a band.
+   * @param band The band.
+   * @return Upper edge (Hz).
+   */
+  float upperEdge(unsigned char band) const {
+    return center(band) * exp2f(0.5f / perOctave);
+  }
+
+  /**
+   * @brief Adds the energy of each band of a spectrum, in one pass over the bins.
+   * @param spectrum The spectrum.
+   * @param energy Slots of the energies, bands + 3, added to.
+   */
+  void accumulate(const float _Complex *spectrum, float *energy) const {
+    for (unsigned short k = 1; k < bins; k++) {
+      float re = crealf(spectrum[k]);
+      float im = cimagf(spectrum[k]);
+      float e = re * re + im * im;
+      float lower = weight[k] * e;
+      energy[slot[k]] += lower;
+      energy[slot[k] + 1] += e - lower;
+    }
+  }
+};
+
+/**
+ * @brief State of the band analyzer modes.
+ */
+struct OctaveBandsState {
+  BandTable table; /**< Bin to band table. */
+  float energy[BAND_MAX_BANDS + 3]; /**< Energy of each slot since the last frame. */
+  float leq[BAND_MAX_BANDS]; /**< Energy of each band since the mode started. */
+  unsigned short level[BAND_MAX_BANDS]; /**< Level of each bar in the last frame, in pixels. */
+  PeakHold peaks; /**< Peak markers. */
+  unsigned long captures; /**< Captures since the last frame. */
+  unsigned long leqCaptures; /**< Captures since the mode started. */
+  unsigned long since; /**< Time the mode started (ms). */
+};
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Converts the mean energy of a band to dBFS.
+ * @param energy Energy summed over the captures.
+ * @param captures Number of captures.
+ * @return Level (dB), -BAND_RANGE_DB for silence.
+ */
+float bandLevel(float energy, unsigned long captures);
+
+/**
+ * @brief Converts a level to the height of a bar.
+ * @param db Level (dBFS).
+ * @param pixels Height of the graph.
+ * @return Height in pixels, <= pixels.
+ */
+unsigned short bandPixels(float db, unsigned short pixels);
+
+/**
+ * @brief Initializes a band analyzer mode: builds the table and draws the band labels.
+ * @param state The mode state.
+ * @param bandsPerOctave 1 for octaves, 3 for third-octaves.
+ */
+void initBands(OctaveBandsState &state, unsigned char bandsPerOctave);
+
+/**
+ * @brief Initializes the octave band analyzer.
+ * @param state The mode state.
+ */
+void initOctaveBands(OctaveBandsState &state);
+
+/**
+ * @brief Initializes the third-octave band analyzer.
+ * @param state The mode state.
+ */
+void initThirdOctaveBands(OctaveBandsState &state);
+
+/**
+ * @brief Adds the band energies of the capture and, when a frame is due, draws the bars.
+ * @param state The mode state.
+ * @param frame The last capture.
+ */
+void displayOctaveBands(OctaveBandsState &state, const BusFrame &frame);
+
+// ---------- Code --------------
+float bandLevel(float energy, unsigned long captures) {
+  if (energy <= 0 or captures == 0) return -BAND_RANGE_DB;
+  return 10.0f * log10f(energy / captures) - BAND_FULL_SCALE_DB;
+}
+
+unsigned short bandPixels(float db, unsigned short pixels) {
+  float fraction = (db + BAND_RANGE_DB) / BAND_RANGE_DB;
+  if (fraction <= 0) return 0;
+  return min((unsigned short)(fraction * pixels), pixels);
+}
+
+void initBands(OctaveBandsState &state, unsigned char bandsPerOctave) {
+  const short axisY = DISPLAY_HEIGHT - FONT_HEIGHT + 2;
+  BandTable &table = state.table;
+  table.build(bandsPerOctave, BUS_SAMPLES / 2, BUS_HZ_PER_BIN);
+  state.peaks.reset(table.bands, BAND_PEAK_HOLD, BAND_PEAK_DECAY, 0);
+  state.since = millis();
+
+  // Labels of the octave centers, skipping those that would touch the previous one.
+  display.clearDisplay();
+  display.setTextColor(SSD1306_WHITE);
+  display.setTextSize(1);
+  unsigned char pitch = DISPLAY_WIDTH / table.bands;
+  short left = (DISPLAY_WIDTH - pitch * table.bands) / 2;
+  short lastRight = -FONT_WIDTH;
+  TextLine text;
+  for (unsigned char b = 0; b < table.bands; b++) {
+    if ((table.firstK + b) % table.perOctave != 0) continue;
+    int hz = round(table.center(b));
+    text.clear();
+    if (hz >= 1000) text.addInt(hz / 1000).add('k');
+    else text.addInt(hz);
+    short width = strlen(text.c_str()) * FONT_WIDTH;
+    short x = left + b * pitch + pitch / 2;
+    if (x - width / 2 < lastRight + FONT_WIDTH / 2) continue;
+    drawCenteredText(x, axisY, text.c_str());
+    lastRight = x + width / 2;
+  }
+}
+
+void initOctaveBands(OctaveBandsState &state) {
+  initBands(state, 1);
+}
+
+void initThirdOctaveBands(OctaveBandsState &state) {
+  initBands(state, 3);
+}
+
+void displayOctaveBands(OctaveBandsState &state, const BusFrame &frame) {
+  const BandTable &table = state.table;
+  state.table.accumulate(frame.spectrum, state.energy);
+  state.captures++;
+  if (!governorRender()) return;
+
+  const short axisY = DISPLAY_HEIGHT - FONT_HEIGHT + 2;
+  const unsigned short graphTop = FONT_HEIGHT + 1;
+  const unsigned short pixels = axisY - 1 - graphTop;
+  unsigned char pitch = DISPLAY_WIDTH / table.bands;
+  unsigned char width = pitch - 1 - pitch / 8;
+  short left = (DISPLAY_WIDTH - pitch * table.bands) / 2;
+
+  float total = 0;
+  for (unsigned char b = 0; b < table.bands; b++) {
+    state.leq[b] += state.energy[b + 1];
+    total += state.leq[b];
+    state.level[b] = bandPixels(bandLevel(state.energy[b + 1], state.captures), pixels);
+  }
+  state.leqCaptures += state.captures;
+  state.peaks.update(state.level);
+
+  display.fillRect(0, 0, DISPLAY_WIDTH, axisY - 1, SSD1306_BLACK); // Clear the graph and the header, keep the labels.
+  for (unsigned char b = 0; b < table.bands; b++) {
+    short x = left + b * pitch;
+    unsigned short level = state.level[b];
+    unsigned short peak = state.peaks.level[b];
+    unsigned short leq = bandPixels(bandLevel(state.leq[b], state.leqCaptures), pixels);
+    display.fillRect(x, axisY - 1 - level, width, level, SSD1306_WHITE);
+    if (peak > level) display.drawFastHLine(x, axisY - 1 - peak, width, SSD1306_WHITE);
+    if (leq > 0) display.drawFastHLine(x, axisY - 1 - leq, width, SSD1306_INVERSE);
+  }
+
+  TextLine text;
+  display.setTextColor(SSD1306_WHITE);
+  text.add("Leq ").addInt(round(bandLevel(total, state.leqCaptures))).add(" dBFS ");
+  drawText(0, 0, text.addInt((millis() - state.since) / 1000).add(" s").c_str());
+
+  for (unsigned char i = 0; i < table.bands + 3; i++) state.energy[i] = 0;
+  state.captures = 0;
+}
@@ -0,0 +1,187 @@
+/**
+ * @file panelTransfer.h
+ * @brief Transfer planning of the SSD1306 panel memory
+ *
+ * This file contains the dirty tracking of the panel memory, with no dependency on the
+ * display library so the host backend and the benchmark tools can use it too.
+ *
+ * The panel runs in vertical addressing mode: a window of one page is sent column by
+ * column like in horizontal mode, and a window of several pages is sent one column of
+ * page bytes after another, so a spectrogram column is one window of 8 bytes instead of
+ * 8 windows of 1 byte.
+ *
+ * On each flush the dirty column range of each page is trimmed against a shadow copy of
+ * the panel memory, and the changed area is sent either as one window per page or as one
+ * window covering every changed page, whichever costs fewer bytes.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <string.h>
+
+// ---------- Constants --------------
+/**
+ * @brief Maximum number of pages of the panel (64 rows).
+ */
+const unsigned char PANEL_MAX_PAGES = 8;
+
+/**
+ * @brief Maximum number of columns of the panel.
+ */
+const unsigned short PANEL_MAX_WIDTH = 128;
+
+/**
+ * @brief Maximum bytes per I2C transmission (control byte included).
+ */
+#ifdef I2C_BUFFER_LENGTH
+const unsigned short PANEL_WIRE_MAX = I2C_BUFFER_LENGTH < 128 ? I2C_BUFFER_LENGTH : 128;
+#else
+const unsigned short PANEL_WIRE_MAX = 32;
+#endif
+
+/**
+ * @brief Bytes of the commands of a window: control byte, PAGEADDR and COLUMNADDR.
+ */
+const unsigned char PANEL_WINDOW_BYTES = 7;
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Window of the panel memory, sent in vertical addressing order.
+ */
+struct PanelWindow {
+  unsigned char pageFrom; /**< First page. */
+  unsigned char pageTo; /**< Last page. */
+  unsigned char columnFrom; /**< First column. */
+  unsigned char columnTo; /**< Last column. */
+};
+
+/**
+ * @class PanelTransfer
+ * @brief Dirty tracking, shadow trimming and window planning of the panel memory.
+ */
+class PanelTransfer {
+private:
+  unsigned char dirtyFrom[PANEL_MAX_PAGES]; /**< First dirty column of each page. */
+  unsigned char dirtyTo[PANEL_MAX_PAGES]; /**< Last dirty column of each page, < dirtyFrom if clean. */
+  unsigned char shadow[PANEL_MAX_PAGES * PANEL_MAX_WIDTH]; /**< Bytes in the panel memory. */
+  bool shadowValid; /**< False until the first flush. */
+  unsigned short width; /**< Columns of the panel. */
+  unsigned char pages; /**< Pages of the panel. */
+  unsigned short chunk; /**< Maximum bytes per I2C transmission, control byte included. */
+  bool blocks; /**< False to send only one-page windows. */
+
+public:
+  /**
+   * @brief Constructs the planner with every byte dirty.
+   * @param w Columns of the panel (<= PANEL_MAX_WIDTH).
+   * @param p Pages of the panel (<= PANEL_MAX_PAGES).
+   * @param maxTransmission Maximum bytes per I2C transmission, control byte included.
+   */
+  PanelTransfer(unsigned short w, unsigned char p, unsigned short maxTransmission)
+    : shadowValid(false), width(w), pages(p), chunk(maxTransmission), blocks(true) {
+    for (unsigned char page = 0; page < PANEL_MAX_PAGES; page++) {
+      dirtyFrom[page] = 0xFF;
+      dirtyTo[page] = 0;
+    }
+    markDirty(0, width - 1, 0, pages - 1);
+  }
+
+  /**
+   * @brief Enables or disables the windows of several pages.
+   * @param enable False to send one window per page, like horizontal addressing.
+   */
+  void multiPageWindows(bool enable) {
+    blocks = enable;
+  }
+
+  /**
+   * @brief Forgets the panel memory, the next flush sends every dirty byte.
+   */
+  void invalidate() {
+    shadowValid = false;
+  }
+
+  /**
+   * @brief Marks a range of columns of a range of pages as changed. Must be in the panel.
+   * @param x0 First column.
+   * @param x1 Last column.
+   * @param page0 First page.
+   * @param page1 Last page.
+   */
+  void markDirty(unsigned short x0, unsigned short x1, unsigned char page0, unsigned char page1) {
+    for (unsigned char page = page0; page <= page1; page++) {
+      if (dirtyFrom[page] > dirtyTo[page]) {
+        dirtyFrom[page] = x0;
+        dirtyTo[page] = x1;
+      } else {
+        if (x0 < dirtyFrom[page]) dirtyFrom[page] = x0;
+        if (x1 > dirtyTo[page]) dirtyTo[page] = x1;
+      }
+    }
+  }
+
+  /**
+   * @brief Gets the bytes sent for a window.
+   * @param area Data bytes of the window.
+   * @return Command and data bytes, control bytes included.
+   */
+  unsigned long windowCost(unsigned short area) const {
+    return PANEL_WINDOW_BYTES + area + (area + chunk - 2) / (chunk - 1);
+  }
+
+  /**
+   * @brief Sends the changed bytes and clears the dirty ranges.
+   *
+   * @tparam Send Callable with a const PanelWindow &, sends the window from the framebuffer.
+   * @param frame The framebuffer, SSD1306 page layout.
+   * @param send Sends a window.
+   * @return Bytes sent (commands and data).
+   */
+  template <typename Send>
+  unsigned long flush(const unsigned char *frame, Send send) {
+    short from[PANEL_MAX_PAGES];
+    short to[PANEL_MAX_PAGES];
+    short pageFrom = -1, pageTo = -1, blockFrom = width, blockTo = -1;
+    unsigned long pageCost = 0;
+
+    for (unsigned char page = 0; page < pages; page++) {
+      from[page] = dirtyFrom[page];
+      to[page] = dirtyTo[page];
+      dirtyFrom[page] = 0xFF;
+      dirtyTo[page] = 0;
+      const unsigned char *row = frame + page * width;
+      const unsigned char *shadowRow = shadow + page * width;
+      if (shadowValid) { // Trim the bytes the panel already has.
+        while (from[page] <= to[page] and row[from[page]] == shadowRow[from[page]]) from[page]++;
+        while (to[page] >= from[page] and row[to[page]] == shadowRow[to[page]]) to[page]--;
+      }
+      if (from[page] > to[page]) continue;
+      if (pageFrom < 0) pageFrom = page;
+      pageTo = page;
+      if (from[page] < blockFrom) blockFrom = from[page];
+      if (to[page] > blockTo) blockTo = to[page];
+      pageCost += windowCost(to[page] - from[page] + 1);
+    }
+    shadowValid = true;
+    if (pageFrom < 0) return 0;
+
+    unsigned long blockCost = windowCost((pageTo - pageFrom + 1) * (blockTo - blockFrom + 1));
+    if (blocks and pageFrom < pageTo and blockCost < pageCost) {
+      send(PanelWindow{(unsigned char)pageFrom, (unsigned char)pageTo, (unsigned char)blockFrom, (unsigned char)blockTo});
+      for (short page = pageFrom; page <= pageTo; page++) {
+        memcpy(shadow + page * width + blockFrom, frame + page * width + blockFrom, blockTo - blockFrom + 1);
+      }
+      return blockCost;
+    }
+
+    for (short page = pageFrom; page <= pageTo; page++) {
+      if (from[page] > to[page]) continue;
+      send(PanelWindow{(unsigned char)page, (unsigned char)page, (unsigned char)from[page], (unsigned char)to[page]});
+      memcpy(shadow + page * width + from[page], frame + page * width + from[page], to[page] - from[page] + 1);
+    }
+    return pageCost;
+  }
+};
@@ -0,0 +1,222 @@
+/**
+ * @file partialDisplay.h
+ * @brief SSD1306 display with partial updates
+ *
+ * Adafruit_SSD1306::display() sends the whole 1 KB framebuffer over I2C on every frame,
+ * even when only a text or a spectrogram column has changed. PartialSSD1306 tracks the
+ * dirty column range of each page (8 rows) while drawing and sends only those windows,
+ * using the SSD1306 column and page address commands. The windows are planned by
+ * PanelTransfer (panelTransfer.h), with the panel in vertical addressing mode so a column
+ * of several pages goes in a single window.
+ *
+ * A shadow copy of the panel memory trims each dirty range to the bytes that really
+ * changed, so a mode that clears and redraws the same content sends nothing.
+ *
+ * Code that writes the framebuffer directly (getBuffer()) must call markDirty().
+ *
+ * SSD1306Renderer exposes the panel through the Renderer interface.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <Adafruit_SSD1306.h>
+#include "renderer.h"
+#include "panelTransfer.h"
+#include "cycleTelemetry.h"
+
+/**
+ * @class PartialSSD1306
+ * @brief Adafruit_SSD1306 that only sends the changed page/column windows.
+ *
+ * Only rotation 0 is tracked, any other rotation marks the whole screen dirty.
+ */
+class PartialSSD1306 : public Adafruit_SSD1306 {
+private:
+  PanelTransfer transfer; /**< Dirty tracking and window planning. */
+  bool vertical; /**< True once the panel is in vertical addressing mode. */
+  unsigned long bytesSent; /**< Bytes sent to the panel (commands and data). */
+
+  /**
+   * @brief Sends the panel a data window, in vertical addressing order.
+   * @param w The window.
+   */
+  void sendWindow(const PanelWindow &w) {
+    const uint8_t window[] = {
+      SSD1306_PAGEADDR, w.pageFrom, w.pageTo,
+      SSD1306_COLUMNADDR, w.columnFrom, w.columnTo
+    };
+    ssd1306_commandList(window, sizeof(window));
+
+    const unsigned char *frame = getBuffer();
+    wire->beginTransmission(i2caddr);
+    wire->write((uint8_t)0x40);
+    unsigned short bytesOut = 1;
+    for (unsigned short x = w.columnFrom; x <= w.columnTo; x++) {
+      for (unsigned short page = w.pageFrom; page <= w.pageTo; page++) {
+        if (bytesOut >= PANEL_WIRE_MAX) {
+          wire->endTransmission();
+          wire->beginTransmission(i2caddr);
+          wire->write((uint8_t)0x40);
+          bytesOut = 1;
+        }
+        wire->write(frame[page * WIDTH + x]);
+        bytesOut++;
+      }
+    }
+    wire->endTransmission();
+  }
+
+public:
+  /**
+   * @brief Constructs the display, same parameters as Adafruit_SSD1306.
+   * @param w Width in pixels.
+   * @param h Height in pixels.
+   * @param twi I2C bus.
+   * @param rst Reset pin.
+   */
+  PartialSSD1306(uint8_t w, uint8_t h, TwoWire *twi, int8_t rst)
+    : Adafruit_SSD1306(w, h, twi, rst),
+      transfer(min(w, (uint8_t)PANEL_MAX_WIDTH), min((uint8_t)(h / 8), PANEL_MAX_PAGES), PANEL_WIRE_MAX),
+      vertical(false), bytesSent(0) {}
+
+  /**
+   * @brief Initializes the panel, same parameters as Adafruit_SSD1306::begin().
+   *
+   * @details The panel is reset to horizontal addressing and its memory is sent whole on
+   * the next display().
+   *
+   * @return False if the framebuffer can't be allocated.
+   */
+  bool begin(uint8_t switchvcc = SSD1306_SWITCHCAPVCC, uint8_t addr = 0, bool reset = true, bool periphBegin = true) {
+    vertical = false;
+    transfer.invalidate();
+    markDirty(0, 0, WIDTH, HEIGHT);
+    return Adafruit_SSD1306::begin(switchvcc, addr, reset, periphBegin);
+  }
+
+  /**
+   * @brief Marks a rectangle as changed.
+   * @param x Left column.
+   * @param y Top row.
+   * @param w Width.
+   * @param h Height.
+   */
+  void markDirty(int16_t x, int16_t y, int16_t w, int16_t h) {
+    if (getRotation() != 0) {
+      x = 0;
+      y = 0;
+      w = WIDTH;
+      h = HEIGHT;
+    }
+    short x0 = max((short)0, (short)x);
+    short x1 = min((short)(min(WIDTH, (int16_t)PANEL_MAX_WIDTH) - 1), (short)(x + w - 1));
+    short y0 = max((short)0, (short)y);
+    short y1 = min((short)(min(HEIGHT, (int16_t)(PANEL_MAX_PAGES * 8)) - 1), (short)(y + h - 1));
+    if (x0 > x1 or y0 > y1) return;
+    transfer.markDirty(x0, x1, y0 / 8, y1 / 8);
+  }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+    Adafruit_SSD1306::drawPixel(x, y, color);
+    markDirty(x, y, 1, 1);
+  }
+
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+    Adafruit_SSD1306::drawFastHLine(x, y, w, color);
+    markDirty(x, y, w, 1);
+  }
+
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+    Adafruit_SSD1306::drawFastVLine(x, y, h, color);
+    markDirty(x, y, 1, h);
+  }
+
+  /**
+   * @brief Clears the framebuffer. Only the bytes that were lit are sent on display().
+   */
+  void clearDisplay() {
+    Adafruit_SSD1306::clearDisplay();
+    markDirty(0, 0, WIDTH, HEIGHT);
+  }
+
+  /**
+   * @brief Sends the dirty windows to the panel.
+   */
+  void display() {
+    if (wire == nullptr or HEIGHT > PANEL_MAX_PAGES * 8 or WIDTH > PANEL_MAX_WIDTH) { // Not supported, full update.
+      Adafruit_SSD1306::display();
+      return;
+    }
+
+#if ARDUINO >= 157
+    wire->setClock(wireClk);
+#endif
+    if (!vertical) {
+      const uint8_t mode[] = {SSD1306_MEMORYMODE, 0x01};
+      ssd1306_commandList(mode, sizeof(mode));
+      bytesSent += sizeof(mode) + 1;
+      vertical = true;
+    }
+    bytesSent += transfer.flush(getBuffer(), [this](const PanelWindow &w) { sendWindow(w); });
+#if ARDUINO >= 157
+    wire->setClock(restoreClk);
+#endif
+  }
+
+  /**
+   * @brief Gets the bytes sent to the panel since the start.
+   * @return Bytes of commands and data.
+   */
+  unsigned long getBytesSent() const {
+    return bytesSent;
+  }
+};
+
+/**
+ * @class SSD1306Renderer
+ * @brief Renderer of the OLED panel. Forwards the drawing to a PartialSSD1306.
+ */
+class SSD1306Renderer : public Renderer {
+private:
+  PartialSSD1306 &panel; /**< The panel. */
+
+public:
+  /**
+   * @brief Constructs the renderer.
+   * @param p The panel, begin() must be called on it before drawing.
+   */
+  SSD1306Renderer(PartialSSD1306 &p) : Renderer(p.width(), p.height()), panel(p) {}
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+    panel.drawPixel(x, y, color);
+  }
+
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+    panel.drawFastVLine(x, y, h, color);
+  }
+
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+    panel.drawFastHLine(x, y, w, color);
+  }
+
+  void clearDisplay() override {
+    panel.clearDisplay();
+  }
+
+  void display() override {
+    CYCLE_BEGIN(CYC_DISPLAY);
+    panel.display();
+    CYCLE_END(CYC_DISPLAY);
+  }
+
+  uint8_t *getBuffer() override {
+    return panel.getBuffer();
+  }
+
+  void markDirty(int16_t x, int16_t y, int16_t w, int16_t h) override {
+    panel.markDirty(x, y, w, h);
+  }
+};
@@ -0,0 +1,68 @@
+/**
+ * @file peakHold.h
+ * @brief Peak-hold engine of the spectrum displays
+ *
+ * This file contains the peak markers shared by the spectrum modes. Each frame the column
+ * levels (pixels) are max-pooled over a neighbourhood, a peak rises at once to a higher
+ * level, is held for a number of frames and then decays at a fixed rate.
+ *
+ * The update is a single pass over contiguous arrays with selects instead of branches, so
+ * the compiler can vectorize it.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <string.h>
+#include "display.h"
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Peak levels of the columns of a spectrum.
+ */
+struct PeakHold {
+  unsigned short level[DISPLAY_WIDTH]; /**< Peak level of each column, in pixels. */
+  unsigned char hold[DISPLAY_WIDTH]; /**< Frames left before the peak decays. */
+  unsigned short columns; /**< Number of columns. */
+  unsigned char holdFrames; /**< Frames a new peak is held. */
+  unsigned char decay; /**< Pixels the peak falls per frame after the hold. */
+  unsigned char radius; /**< Columns pooled on each side. */
+
+  /**
+   * @brief Clears the peaks and sets the parameters.
+   * @param cols Number of columns (<= DISPLAY_WIDTH).
+   * @param holdTime Frames a new peak is held.
+   * @param decayRate Pixels the peak falls per frame after the hold.
+   * @param poolRadius Columns pooled on each side (0 for none).
+   */
+  void reset(unsigned short cols, unsigned char holdTime, unsigned char decayRate, unsigned char poolRadius) {
+    columns = min(cols, (unsigned short)DISPLAY_WIDTH);
+    holdFrames = holdTime;
+    decay = decayRate;
+    radius = poolRadius;
+    memset(level, 0, sizeof(level));
+    memset(hold, 0, sizeof(hold));
+  }
+
+  /**
+   * @brief Updates the peaks with the levels of a frame.
+   * @param levels Level of each column, in pixels.
+   */
+  void update(const unsigned short *levels) {
+    const short last = columns - 1;
+    for (short x = 0; x < columns; x++) {
+      unsigned short pooled = levels[x];
+      for (short j = 1; j <= radius; j++) {
+        pooled = max(pooled, levels[max((short)0, (short)(x - j))]);
+        pooled = max(pooled, levels[min(last, (short)(x + j))]);
+      }
+      unsigned short current = level[x];
+      bool rise = pooled >= current;
+      unsigned char fall = hold[x] == 0 ? min((unsigned short)decay, current) : 0;
+      level[x] = rise ? pooled : current - fall;
+      hold[x] = rise ? holdFrames : hold[x] - (hold[x] > 0);
+    }
+  }
+};
@@ -0,0 +1,125 @@
+/**
+ * @file pitchDetector.h
+ * @brief Pitch of a capture by FFT autocorrelation
+ *
+ * This file contains the estimation of the fundamental frequency of a capture. The peak bin
+ * of a spectrum is the strongest partial, which may be a harmonic: a doorbell or a voice
+ * often has a stronger second or third harmonic than its fundamental. The autocorrelation
+ * peaks at the period of the fundamental instead, as every harmonic repeats with it.
+ *
+ * The autocorrelation is the inverse FFT of the power spectrum (Wiener-Khinchin), so it
+ * reuses the spectrum of the capture and the FFT of fft.h in the inverse direction: one
+ * FFT of the capture size per capture, O(N log N). The capture is windowed (Hamming), so
+ * the wrap-around of the circular autocorrelation only mixes the tapered ends.
+ *
+ * The pitch is the lag of the first autocorrelation peak within PITCH_PEAK_RATIO of the
+ * highest one in the lag range, which avoids the multiples of the period, refined with a
+ * parabola through the peak and its neighbours. Its height relative to the zero lag (the
+ * clarity) tells a periodic sound (near 1) from noise.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <math.h>
+#include <complex.h>
+#include "Arduino.h"
+#include "fft.h"
+
+// ---------- Constants --------------
+/**
+ * @brief Largest capture of the detector.
+ */
+const unsigned short PITCH_MAX_SAMPLES = 1024;
+
+/**
+ * @brief Lowest pitch (Hz).
+ */
+const float PITCH_MIN_HZ = 60.0f;
+
+/**
+ * @brief Highest pitch (Hz).
+ */
+const float PITCH_MAX_HZ = 2000.0f;
+
+/**
+ * @brief A peak this close to the highest one is taken if it comes first (shorter period).
+ */
+const float PITCH_PEAK_RATIO = 0.9f;
+
+/**
+ * @brief Lowest clarity of a voiced capture.
+ */
+const float PITCH_MIN_CLARITY = 0.5f;
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Pitch of a capture.
+ */
+struct PitchEstimate {
+  float hz; /**< Fundamental frequency (Hz), 0 if none. */
+  float clarity; /**< Autocorrelation of the period relative to the zero lag, 0 to 1. */
+  bool voiced; /**< True if the capture is periodic enough, clarity >= PITCH_MIN_CLARITY. */
+};
+
+/**
+ * @namespace pitchDetector
+ * @brief Namespace for the autocorrelation buffer.
+ */
+namespace pitchDetector {
+  float _Complex work[PITCH_MAX_SAMPLES]; /**< Power spectrum, then autocorrelation. */
+}
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Estimates the pitch of a capture from its spectrum.
+ * @param spectrum The whole spectrum of the capture (all the bins, not only up to Nyquist).
+ * @param log2N Logarithm base 2 of the size of the capture, PITCH_MAX_SAMPLES at most.
+ * @param sampleHz Sampling frequency (Hz).
+ * @param pitch Output: the estimate.
+ */
+void estimatePitch(const float _Complex *spectrum, unsigned char log2N, float sampleHz, PitchEstimate &pitch);
+
+// ---------- Code --------------
+void estimatePitch(const float _Complex *spectrum, unsigned char log2N, float sampleHz, PitchEstimate &pitch) {
+  unsigned short n = 1 << log2N;
+  float _Complex *r = pitchDetector::work;
+  pitch = {0, 0, false};
+
+  for (unsigned short k = 0; k < n; k++) {
+    float re = crealf(spectrum[k]);
+    float im = cimagf(spectrum[k]);
+    r[k] = re * re + im * im;
+  }
+  // evaluateFFT() and not performFFT(), which clears the first bin: here the zero lag.
+  rearrangeForIFFT(r, log2N);
+  evaluateFFT(r, log2N, FFT_INVERSE);
+
+  float r0 = crealf(r[0]);
+  if (r0 <= 0) return;
+  unsigned short minLag = max(2, (int)(sampleHz / PITCH_MAX_HZ));
+  unsigned short maxLag = min(n / 2 - 2, (int)ceilf(sampleHz / PITCH_MIN_HZ));
+
+  float highest = 0;
+  for (unsigned short t = minLag; t <= maxLag; t++) {
+    float v = crealf(r[t]);
+    if (v > highest and v > crealf(r[t - 1]) and v >= crealf(r[t + 1])) highest = v;
+  }
+  if (highest <= 0) return;
+
+  unsigned short lag = minLag;
+  while (lag <= maxLag) {
+    float v = crealf(r[lag]);
+    if (v >= PITCH_PEAK_RATIO * highest and v > crealf(r[lag - 1]) and v >= crealf(r[lag + 1])) break;
+    lag++;
+  }
+  float before = crealf(r[lag - 1]), peak = crealf(r[lag]), after = crealf(r[lag + 1]);
+  float curvature = before - 2 * peak + after;
+  float offset = curvature < 0 ? 0.5f * (before - after) / curvature : 0;
+
+  pitch.hz = sampleHz / (lag + offset);
+  pitch.clarity = min(1.0f, peak / r0);
+  pitch.voiced = pitch.clarity >= PITCH_MIN_CLARITY;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file psdAverage.h
+ * @brief Averaged power spectral density of the captures
+ *
+ * This file contains the average of the power spectra (periodograms) of the captures, as
+ * in Welch's method: the power of a single capture fluctuates as much as its mean in every
+ * bin of noise, and averaging K captures divides that variance by K, so a steady tone
+ * stands out of the noise instead of the noise peaks coming and going.
+ *
+ * The average is incremental, in fixed memory and O(bins) per capture: the mean of the
+ * first K captures, then an exponential average with weight 1 / K, which keeps about the
+ * last K captures. The variance of each bin is averaged with it (West's weighted update),
+ * so a steady tone (low variance) can be told from noise (a standard deviation as large as
+ * the mean).
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <string.h>
+#include <complex.h>
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Running average and variance of the power of N spectrum bins.
+ * @tparam N Number of bins.
+ */
+template <unsigned short N>
+struct PsdAverage {
+  float mean[N]; /**< Mean power of each bin. */
+  float variance[N]; /**< Variance of the power of each bin. */
+  unsigned short length; /**< Captures of the average (K). */
+  unsigned short count; /**< Captures averaged since the last reset, up to length. */
+
+  /**
+   * @brief Clears the average.
+   * @param averages Captures of the average, 1 for none.
+   */
+  void reset(unsigned short averages) {
+    length = averages > 0 ? averages : 1;
+    memset(mean, 0, sizeof(mean));
+    memset(variance, 0, sizeof(variance));
+    count = 0;
+  }
+
+  /**
+   * @brief Adds the power spectrum of a capture.
+   * @param spectrum The spectrum, N bins or more.
+   */
+  void add(const float _Complex *spectrum) {
+    if (count < length) count++;
+    float weight = 1.0f / count;
+    for (unsigned short k = 0; k < N; k++) {
+      float re = crealf(spectrum[k]);
+      float im = cimagf(spectrum[k]);
+      float delta = re * re + im * im - mean[k];
+      mean[k] += weight * delta;
+      variance[k] = (1.0f - weight) * (variance[k] + weight * delta * delta);
+    }
+  }
+
+  /**
+   * @brief Finds the bin of the highest mean power.
+   * @param from First bin of the search.
+   * @param power Output: mean power of the bin, 0 if none.
+   * @return The bin, 0 if none.
+   */
+  unsigned short peak(unsigned short from, float &power) const {
+    unsigned short bin = 0;
+    power = 0;
+    for (unsigned short k = from; k < N; k++) {
+      if (mean[k] > power) {
+        power = mean[k];
+        bin = k;
+      }
+    }
+    return bin;
+  }
+};
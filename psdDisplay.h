@@ -0,0 +1,169 @@
+/**
+ * @file psdDisplay.h
+ * @brief Averaged power spectral density modes
+ *
+ * This file contains the Welch PSD modes: the power spectrum of the captures averaged over
+ * a selectable number of captures (see psdAverage.h), in dB from the power of a full-scale
+ * sine. Unlike the spectrum modes, which show the noisy spectrum of the last captures and
+ * hold their peaks, the average settles: the noise becomes a smooth floor and a steady
+ * tone a stable line above it.
+ *
+ * Each column shows the highest mean power of its bins as a vertical line and, as a dot
+ * above it, the mean plus one standard deviation: on a steady tone the dot touches the
+ * line, on noise it stands about 3 dB above. The header shows the captures averaged and
+ * the frequency of the highest bin.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <math.h>
+#include "display.h"
+#include "textOverlay.h"
+#include "frameGovernor.h"
+#include "spectrumBus.h"
+#include "spectrumScale.h"
+#include "psdAverage.h"
+
+// ---------- Constants --------------
+/**
+ * @brief Captures of the short average.
+ */
+const unsigned short PSD_SHORT_AVERAGES = 8;
+
+/**
+ * @brief Captures of the long average.
+ */
+const unsigned short PSD_LONG_AVERAGES = 32;
+
+/**
+ * @brief First bin of the graph (62 Hz).
+ */
+const unsigned short PSD_FROM_BIN = BUS_SAMPLES / 256;
+
+/**
+ * @brief Power of a full-scale sine (ADC swing of 2048) in its bin, Hamming window of
+ * BUS_SAMPLES (dB): (2048 * BUS_SAMPLES * 0.54 / 2)^2.
+ */
+const float PSD_FULL_SCALE_DB = 115.1f;
+
+/**
+ * @brief Range of the graph below full scale (dB).
+ */
+const float PSD_RANGE_DB = 72.0f;
+
+// ---------- Struct Definition --------------
+/**
+ * @brief State of the Welch PSD modes.
+ */
+struct PsdState {
+  PsdAverage<BUS_PSD_BINS> average; /**< Averaged power spectrum. */
+  SpectrumMap map; /**< Column to bin table. */
+};
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Converts a power to the height of a column.
+ * @param power Power of a bin.
+ * @param pixels Height of the graph.
+ * @return Height in pixels, <= pixels.
+ */
+unsigned short psdPixels(float power, unsigned short pixels);
+
+/**
+ * @brief Initializes a Welch PSD mode: clears the average and draws the frequency labels.
+ * @param state The mode state.
+ * @param averages Captures of the average.
+ */
+void initPsd(PsdState &state, unsigned short averages);
+
+/**
+ * @brief Initializes the Welch PSD of PSD_SHORT_AVERAGES captures.
+ * @param state The mode state.
+ */
+void initPsdShort(PsdState &state);
+
+/**
+ * @brief Initializes the Welch PSD of PSD_LONG_AVERAGES captures.
+ * @param state The mode state.
+ */
+void initPsdLong(PsdState &state);
+
+/**
+ * @brief Adds the capture to the average and, when a frame is due, draws it.
+ * @param state The mode state.
+ * @param frame The last capture.
+ */
+void displayPsd(PsdState &state, const BusFrame &frame);
+
+// ---------- Code --------------
+unsigned short psdPixels(float power, unsigned short pixels) {
+  if (power <= 0) return 0;
+  float fraction = (10.0f * log10f(power) - PSD_FULL_SCALE_DB + PSD_RANGE_DB) / PSD_RANGE_DB;
+  if (fraction <= 0) return 0;
+  return min((unsigned short)(fraction * pixels), pixels);
+}
+
+void initPsd(PsdState &state, unsigned short averages) {
+  const short axisY = DISPLAY_HEIGHT - FONT_HEIGHT + 2;
+  state.average.reset(averages);
+  state.map.build(SCALE_LINEAR, DISPLAY_WIDTH - 1, PSD_FROM_BIN, BUS_PSD_BINS, BUS_HZ_PER_BIN, 1, axisY - 1);
+
+  // Static labels, drawn once.
+  display.clearDisplay();
+  display.setTextColor(SSD1306_WHITE);
+  display.setTextSize(1);
+  TextLine text;
+  for (unsigned char i = 1; i <= 6; i++) {
+    drawCenteredText(state.map.columnOf(1000 * i), axisY, text.clear().addInt(i).c_str());
+  }
+  drawText(DISPLAY_WIDTH - (FONT_WIDTH * 3), axisY, "kHz");
+}
+
+void initPsdShort(PsdState &state) {
+  initPsd(state, PSD_SHORT_AVERAGES);
+}
+
+void initPsdLong(PsdState &state) {
+  initPsd(state, PSD_LONG_AVERAGES);
+}
+
+void displayPsd(PsdState &state, const BusFrame &frame) {
+  const PsdAverage<BUS_PSD_BINS> &average = state.average;
+  const SpectrumMap &map = state.map;
+  state.average.add(frame.spectrum);
+  if (!governorRender()) return;
+
+  const short axisY = DISPLAY_HEIGHT - FONT_HEIGHT + 2;
+  const unsigned short graphTop = FONT_HEIGHT + 1;
+  const unsigned short pixels = axisY - 1 - graphTop;
+  display.fillRect(0, 0, DISPLAY_WIDTH, axisY, SSD1306_BLACK); // Clear the graph and the header, keep the labels.
+
+  float highest = 0;
+  unsigned short highestBin = 0;
+  for (unsigned short x = 0; x < map.columns; x++) {
+    unsigned short bin = map.firstBin[x];
+    for (unsigned short k = map.firstBin[x] + 1; k <= map.lastBin[x] and k < BUS_PSD_BINS; k++) {
+      if (average.mean[k] > average.mean[bin]) bin = k;
+    }
+    float mean = average.mean[bin];
+    if (mean > highest) {
+      highest = mean;
+      highestBin = bin;
+    }
+    unsigned short level = psdPixels(mean, pixels);
+    unsigned short spread = psdPixels(mean + sqrtf(average.variance[bin]), pixels);
+    display.drawFastVLine(x, axisY - 1 - level, level, SSD1306_WHITE);
+    if (spread > level) display.drawPixel(x, axisY - 1 - spread, SSD1306_WHITE);
+  }
+
+  TextLine text;
+  display.setTextColor(SSD1306_WHITE);
+  drawText(0, 0, text.add("Avg ").addInt(average.count).add('/').addInt(average.length).c_str());
+  text.clear();
+  if (highestBin > 0) text.addInt(round(highestBin * BUS_HZ_PER_BIN)).add(" Hz");
+  else text.add("- Hz");
+  drawText(DISPLAY_WIDTH - FONT_WIDTH * strlen(text.c_str()), 0, text.c_str());
+}
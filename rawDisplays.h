@@ -11,6 +11,8 @@
 
 #include "board.h"
 #include "display.h"
+#include "textOverlay.h"
+#include "spectrumBus.h"
 
 // Namespaces
 #include "soundAnalysisToolsNamespaces.h"
@@ -18,81 +20,146 @@ using namespace commonSoundAnalysisTools;
 using namespace commonDisplays;
 using namespace minMax;
 
+// Constants
+const unsigned short ENVELOPE_WINDOW = BUS_SAMPLES / 8; /**< Samples of an envelope column (8 ms). */
+
+// Struct Definition
+/**
+ * @brief State of the sweeping envelope.
+ */
+struct SweepingEnvelopeState {
+  unsigned short i; /**< Column of the cursor. */
+  unsigned short ampPrev; /**< Amplitude of the previous column. */
+};
+
+/**
+ * @brief State of the running envelope.
+ */
+struct RunningEnvelopeState {
+  short data[DISPLAY_WIDTH]; /**< Amplitude of each column, newest on the right. */
+};
+
+/**
+ * @brief State of the amplitude bars.
+ */
+struct AmplitudeBarsState {
+  short data[DISPLAY_WIDTH]; /**< Samples, one per column. */
+  unsigned short midPoint; /**< Row of the zero amplitude. */
+};
+
 
 // Headers
+/**
+ * @brief Initializes the sweeping envelope graph.
+ *
+ * @details This function clears the display and draws the fixed content.
+ *
+ * @param state The mode state.
+ */
+void initSweepingEnvelope(SweepingEnvelopeState &state);
+
 /**
  * @brief Display the sweeping envelope graph.
  *
  * @details This function displays the sweeping envelope graph on the display. It
- * samples the sound input from the microphone and calculates the peak values
- * to determine the amplitude of the sound. The graph is updated in real-time,
+ * splits the capture of the bus in windows and calculates the peak values of each
+ * window to determine the amplitude of the sound, one column per window. The graph is updated in real-time,
  * creating a sweeping effect as the values change. The graph is displayed
  * vertically, with higher amplitudes shown at the bottom and lower amplitudes
  * at the top.
  * 
- * @param initial Set to true to clear the display and draw the fixed content.
- *              Recommended to use only the first time the function is called.
+ * @param state The mode state.
+ * @param frame The last capture.
  */
-void displaySweepingEnvelope(bool initial);
+void displaySweepingEnvelope(SweepingEnvelopeState &state, const BusFrame &frame);
+
+/**
+ * @brief Draws a column of the sweeping envelope graph and moves the cursor.
+ *
+ * @param state The mode state.
+ * @param peakMax Highest sample of the window, from the silence level.
+ * @param peakMin Lowest sample of the window, from the silence level.
+ */
+void sweepEnvelopeColumn(SweepingEnvelopeState &state, short peakMax, short peakMin);
+
+/**
+ * @brief Initializes the running envelope graph.
+ *
+ * @details This function clears the display and the envelope.
+ *
+ * @param state The mode state.
+ */
+void initRunningEnvelope(RunningEnvelopeState &state);
 
 /**
  * @brief Display the running envelope graph.
  *
- * @details This function displays the running envelope graph on the display. It samples
- * the sound input from the microphone and calculates the peak values to
+ * @details This function displays the running envelope graph on the display. It splits
+ * the capture of the bus in windows and calculates the peak values of each window to
  * determine the amplitude of the sound. The graph shows the envelope of the
  * sound over time, with the oldest data gradually fading out as new data is
  * added. The graph is displayed vertically, with higher amplitudes shown at
  * the bottom and lower amplitudes at the top.
  *  
- * @param initial Set to true to clear the display and draw the fixed content.
- *              Recommended to use only the first time the function is called.
+ * @param state The mode state.
+ * @param frame The last capture.
+ */
+void displayRunningEnvelope(RunningEnvelopeState &state, const BusFrame &frame);
+
+/**
+ * @brief Initializes the amplitude bars graph.
+ *
+ * @details This function sets up the layout of the bars.
+ *
+ * @param state The mode state.
  */
-void displayRunningEnvelope(bool initial);
+void initAmplitudeBars(AmplitudeBarsState &state);
 
 /**
  * @brief Display the amplitude bars graph.
  *
- * @details This function displays the amplitude bars graph on the display. It samples
- * the sound input from the microphone and calculates the amplitudes of the
+ * @details This function displays the amplitude bars graph on the display. It takes
+ * the last samples of the capture of the bus and calculates the amplitudes of the
  * sound. The graph consists of vertical bars, where each bar represents the
  * amplitude of a specific sample. The height of each bar corresponds to the
  * amplitude value, with higher and lower amplitudes shown as bars.
  *  
- * @param initial Set to true to initialize the display and set up the fixed content.
- *                Recommended to use only the first time the function is called.
+ * @param state The mode state.
+ * @param frame The last capture.
  */
-void displayAmplitudeBars(bool initial);
+void displayAmplitudeBars(AmplitudeBarsState &state, const BusFrame &frame);
 
 // Code
-void displaySweepingEnvelope(bool initial) { 
-  static unsigned short i = 0;
-  static unsigned short ampPrev = 0;
-
-  if (initial) {
-    title[0] = "Sweeping";
-    title[1] = "Envelope";
-    display.clearDisplay();
-    display.setTextSize(1); 
-    display.cp437(true);  // Use full 256 char 'Code Page 437' font
-    hOffset = FONT_HEIGHT;
-    i = 0;
-  }  
+void initSweepingEnvelope(SweepingEnvelopeState &state) {
+  display.clearDisplay();
+  display.setTextSize(1); 
+  display.cp437(true);  // Use full 256 char 'Code Page 437' font
+  hOffset = FONT_HEIGHT;
+  state.i = 0;
+}
+
+void displaySweepingEnvelope(SweepingEnvelopeState &state, const BusFrame &frame) { 
+  for (unsigned short from = 0; from < BUS_SAMPLES; from += ENVELOPE_WINDOW) {
+    short peakMax = -MAX_READ_VALUE;
+    short peakMin = MAX_READ_VALUE;
+    for (unsigned short n = from; n < from + ENVELOPE_WINDOW; n++) {
+      short sample = frame.samples[n] - SILENCE;
+      peakMax = max(sample, peakMax);
+      peakMin = min(sample, peakMin);
+    }
+    sweepEnvelopeColumn(state, peakMax, peakMin);
+  }
+}
+
+void sweepEnvelopeColumn(SweepingEnvelopeState &state, short peakMax, short peakMin) {
+  unsigned short &i = state.i;
+  unsigned short &ampPrev = state.ampPrev;
    
   if (i >= DISPLAY_WIDTH || i == 0) {
     i = 0;
     ampMax = -MAX_READ_VALUE;
     ampMin = MAX_READ_VALUE;
   }  
-  
-  short peakMax = -MAX_READ_VALUE;
-  short peakMin = MAX_READ_VALUE;
-  chrono = micros(); // Sample window 10ms
-  while (micros() - chrono < 10000ul) {
-    short sample = analogRead(MIC_PIN) - SILENCE;
-    peakMax = max(sample, peakMax);
-    peakMin = min(sample, peakMin);
-  }  
 
   short x = peakMax - peakMin;
   short amp = map(x, 0, MAX_READ_VALUE - SILENCE, 0, DISPLAY_HEIGHT - hOffset);
@@ -122,83 +189,76 @@ void displaySweepingEnvelope(bool initial) {
     if (amp < ampMin) ampMin = amp;
     display.fillRect(0, 0, DISPLAY_WIDTH, FONT_HEIGHT, SSD1306_BLACK);    
     display.setTextColor(SSD1306_WHITE);
-    display.setCursor(0, 0);
-    String text = "Min: " + String(ampMin);
-    display.println(text);
-    display.setCursor(FONT_WIDTH * 10, 0);  
-    text = "Max: " + String(ampMax);
-    display.println(text);
+    TextLine text;
+    drawText(0, 0, text.add("Min: ").addInt(ampMin).c_str());
+    drawText(FONT_WIDTH * 10, 0, text.clear().add("Max: ").addInt(ampMax).c_str());
   }
   ++i;
 }
 
-void displayRunningEnvelope(bool initial) {
-  static short data[DISPLAY_WIDTH] = {0};
-
-  if (initial) {
-    title[0] = "Running";
-    title[1] = "Envelope";
-    display.clearDisplay();
-    display.setTextSize(1); 
-    display.cp437(true);  // Use full 256 char 'Code Page 437' font
-    // Clear data
-    for (unsigned short i = 0; i < DISPLAY_WIDTH; i++) data[i] = 0;
-  }
+void initRunningEnvelope(RunningEnvelopeState &state) {
+  display.clearDisplay();
+  display.setTextSize(1); 
+  display.cp437(true);  // Use full 256 char 'Code Page 437' font
+  // Clear data
+  for (unsigned short i = 0; i < DISPLAY_WIDTH; i++) state.data[i] = 0;
+}
+
+void displayRunningEnvelope(RunningEnvelopeState &state, const BusFrame &frame) {
+  short *data = state.data;
   
   hOffset = FONT_HEIGHT;
-  short lostSound = data[0];
-  for (unsigned short i = 0; i < DISPLAY_WIDTH - 1 ; i++) data[i] = data[i + 1]; // move data
-  
-  chrono = micros(); // Sample window 10ms
-  while (micros() - chrono < 10000ul) {
-    short sample = analogRead(MIC_PIN) - SILENCE;
-    if (sample > ampMax) ampMax = sample;
-    else if (sample < ampMin) ampMin = sample;
-  }
+  for (unsigned short from = 0; from < BUS_SAMPLES; from += ENVELOPE_WINDOW) {
+    for (unsigned short i = 0; i < DISPLAY_WIDTH - 1 ; i++) data[i] = data[i + 1]; // move data
 
-  short x = ampMax - ampMin;
-  data[DISPLAY_WIDTH - 1] = map(x, 0, short(MAX_READ_VALUE - SILENCE), 0, short(DISPLAY_HEIGHT - hOffset));
-  data[DISPLAY_WIDTH - 1] = min(short(DISPLAY_HEIGHT - hOffset), data[DISPLAY_WIDTH - 1]);
+    short peakMax = -MAX_READ_VALUE;
+    short peakMin = MAX_READ_VALUE;
+    for (unsigned short n = from; n < from + ENVELOPE_WINDOW; n++) {
+      short sample = frame.samples[n] - SILENCE;
+      peakMax = max(sample, peakMax);
+      peakMin = min(sample, peakMin);
+    }
 
+    short x = peakMax - peakMin;
+    data[DISPLAY_WIDTH - 1] = map(x, 0, short(MAX_READ_VALUE - SILENCE), 0, short(DISPLAY_HEIGHT - hOffset));
+    data[DISPLAY_WIDTH - 1] = min(short(DISPLAY_HEIGHT - hOffset), data[DISPLAY_WIDTH - 1]);
+  }
+
+  // Several columns move per capture: redraw the whole graph.
   ampMin = DISPLAY_HEIGHT - hOffset;
   ampMax = 0;  
-  display.drawLine (0, DISPLAY_HEIGHT - lostSound, 1, DISPLAY_HEIGHT - data[0], SSD1306_BLACK);
+  display.fillRect(0, hOffset, DISPLAY_WIDTH, DISPLAY_HEIGHT - hOffset, SSD1306_BLACK);
   for (short i = 1; i < DISPLAY_WIDTH; i++) {
     if (data[i] > ampMax) ampMax = data[i];
     if (data[i] < ampMin) ampMin = data[i];
-    display.drawLine (i, DISPLAY_HEIGHT - (short)data[i - 1], i + 1, DISPLAY_HEIGHT - (short)data[i], SSD1306_BLACK);
     display.drawLine (i - 1, DISPLAY_HEIGHT - (short)data[i - 1], i, DISPLAY_HEIGHT - (short)data[i], SSD1306_WHITE);
   }  
 
   display.fillRect(0, 0, DISPLAY_WIDTH, FONT_HEIGHT, SSD1306_BLACK);  
   display.setTextColor(SSD1306_WHITE);
-  display.setCursor(0, 0);
-  String text = "Min: " + String(ampMin);
-  display.println(text);
-  display.setCursor(FONT_WIDTH * 10, 0);  
-  text = "Max: " + String(ampMax);
-  display.println(text);
+  TextLine text;
+  drawText(0, 0, text.add("Min: ").addInt(ampMin).c_str());
+  drawText(FONT_WIDTH * 10, 0, text.clear().add("Max: ").addInt(ampMax).c_str());
 }
 
-void displayAmplitudeBars(bool initial) {
-  static const unsigned short SAMPLES = 128;  // = DISPLAY_WIDTH
-  static short data[SAMPLES];
-  static unsigned short midPoint_AMPB;
-
-  if (initial) {
-    title[0] = "Amplitude Bars";
-    hOffset = FONT_HEIGHT - 1;
-    graphH = DISPLAY_HEIGHT - hOffset;
-    midPoint_AMPB = (graphH / 2) + hOffset;    
-    display.setTextSize(1); 
-    display.cp437(true);  // Use full 256 char 'Code Page 437' font
-  }
+void initAmplitudeBars(AmplitudeBarsState &state) {
+  hOffset = FONT_HEIGHT - 1;
+  graphH = DISPLAY_HEIGHT - hOffset;
+  state.midPoint = (graphH / 2) + hOffset;    
+  display.setTextSize(1); 
+  display.cp437(true);  // Use full 256 char 'Code Page 437' font
+}
+
+void displayAmplitudeBars(AmplitudeBarsState &state, const BusFrame &frame) {
+  short *data = state.data;
+  const unsigned short midPoint_AMPB = state.midPoint;
+
   ampMax = 0;
   ampMin = MAX_READ_VALUE;
   
   display.clearDisplay();
   for (unsigned short i = 0; i < DISPLAY_WIDTH; i++) {
-    data[i] = analogRead(MIC_PIN);
+    data[i] = frame.samples[BUS_SAMPLES - DISPLAY_WIDTH + i];
     short amplitude = data[i] - SILENCE;    
     ampMax = max(ampMax, amplitude);
     ampMin = min(ampMin, amplitude);
@@ -207,8 +267,7 @@ void displayAmplitudeBars(bool initial) {
   } 
 
   display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
-  display.setCursor(0, 0);
-  display.println("Max: " + String(ampMax));
-  display.setCursor(60, 0);
-  display.println("Min: " + String(ampMin));
+  TextLine text;
+  drawText(0, 0, text.add("Max: ").addInt(ampMax).c_str());
+  drawText(60, 0, text.clear().add("Min: ").addInt(ampMin).c_str());
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+/**
+ * @file renderer.h
+ * @brief Renderer interface
+ *
+ * Every display mode draws on the global `display` object. Renderer is the interface
+ * that object implements: the Adafruit_GFX drawing primitives plus the framebuffer
+ * operations of the SSD1306 (clear, update, direct access to the buffer).
+ *
+ * Implementations:
+ * - SSD1306Renderer (partialDisplay.h): the OLED panel, through PartialSSD1306.
+ * - FramebufferRenderer (framebufferRenderer.h): in-memory framebuffer for host builds,
+ *   with frame dumps and draw cost counters.
+ *
+ * The framebuffer layout is the SSD1306 one: one byte per column and 8-row page, bit k of
+ * page p is row p * 8 + k. Only rotation 0 is supported.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <Adafruit_GFX.h>
+
+#ifndef SSD1306_BLACK
+#define SSD1306_BLACK 0   ///< Draw 'off' pixels
+#define SSD1306_WHITE 1   ///< Draw 'on' pixels
+#define SSD1306_INVERSE 2 ///< Invert pixels
+#endif
+
+/**
+ * @class Renderer
+ * @brief Drawing target of the display modes.
+ *
+ * Implementations must override drawPixel(), drawFastVLine() and drawFastHLine(), the
+ * other Adafruit_GFX primitives (lines, rectangles, bitmaps, text) are built on them.
+ */
+class Renderer : public Adafruit_GFX {
+public:
+  /**
+   * @brief Constructs the renderer.
+   * @param w Width in pixels.
+   * @param h Height in pixels.
+   */
+  Renderer(int16_t w, int16_t h) : Adafruit_GFX(w, h) {}
+
+  virtual ~Renderer() {}
+
+  /**
+   * @brief Clears the framebuffer.
+   */
+  virtual void clearDisplay() = 0;
+
+  /**
+   * @brief Ends the frame: shows the framebuffer.
+   */
+  virtual void display() = 0;
+
+  /**
+   * @brief Gets the framebuffer, SSD1306 page layout.
+   * @return Pointer to width * height / 8 bytes.
+   */
+  virtual uint8_t *getBuffer() = 0;
+
+  /**
+   * @brief Reports a rectangle written directly in the framebuffer.
+   * @param x Left column.
+   * @param y Top row.
+   * @param w Width.
+   * @param h Height.
+   */
+  virtual void markDirty(int16_t x, int16_t y, int16_t w, int16_t h) = 0;
+
+  /**
+   * @brief Writes a whole column as page bytes, bit k of page p is row p * 8 + k.
+   * @param x Column, nothing is written if it is off the screen.
+   * @param pages HEIGHT / 8 bytes, top page first.
+   */
+  void writeColumn(int16_t x, const uint8_t *pages) {
+    if (x < 0 or x >= WIDTH) return;
+    uint8_t *frame = getBuffer();
+    for (int16_t page = 0; page < HEIGHT / 8; page++) frame[page * WIDTH + x] = pages[page];
+    markDirty(x, 0, 1, HEIGHT);
+  }
+};
@@ -0,0 +1,184 @@
+/**
+ * @file scheduler.h
+ * @brief Cooperative scheduler of the periodic work of the main loop
+ *
+ * This file contains a fixed-capacity scheduler of the work that runs at its own rate
+ * next to the analysis: battery sampling, title expiry, sleep timeout, event log and
+ * telemetry. Each task is periodic or one-shot; a one-shot task is armed (start()) when its
+ * timer begins and can re-arm itself from its routine. The loop calls service() once per
+ * iteration and the due tasks run in order of registration; a task never preempts another
+ * or the analysis, so the tasks share the globals of the loop without locks.
+ *
+ * Each task accounts its runs and run time (service() measures them), and untilNext() tells
+ * the time to the next deadline, so a loop with nothing else to do can sleep until then
+ * (idle()).
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include "Arduino.h"
+
+// ---------- Constants --------------
+/**
+ * @brief Maximum number of tasks.
+ */
+const unsigned char SCHEDULER_TASKS = 8;
+
+/**
+ * @brief Longest sleep of idle() (ms), also with no task armed.
+ */
+const unsigned long SCHEDULER_MAX_IDLE_MS = 1000ul;
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Task of the scheduler.
+ */
+struct ScheduledTask {
+  const char *name; /**< Name, for the statistics. */
+  void (*run)(); /**< Routine. */
+  unsigned long period; /**< Period (ms), 0 for a one-shot task. */
+  unsigned long due; /**< Time of the next run (ms). */
+  bool armed; /**< True if the task will run at due. */
+  unsigned long runs; /**< Runs so far. */
+  unsigned long totalUs; /**< Run time so far (us). */
+  unsigned long maxUs; /**< Longest run (us). */
+};
+
+// ---------- Class Definition --------------
+/**
+ * @class Scheduler
+ * @brief Fixed-capacity cooperative scheduler with periodic and one-shot timers.
+ */
+class Scheduler {
+private:
+  ScheduledTask tasks[SCHEDULER_TASKS]; /**< Registered tasks. */
+  unsigned char count = 0; /**< Number of registered tasks. */
+
+public:
+  /**
+   * @brief Registers a task, not armed.
+   * @param name Name of the task.
+   * @param run Routine of the task.
+   * @param period Period (ms), 0 for a one-shot task.
+   * @return Id of the task, -1 if the scheduler is full.
+   */
+  short add(const char *name, void (*run)(), unsigned long period = 0) {
+    if (count >= SCHEDULER_TASKS) return -1;
+    tasks[count] = {name, run, period, 0, false, 0, 0, 0};
+    return count++;
+  }
+
+  /**
+   * @brief Registers a periodic task and arms it.
+   * @param name Name of the task.
+   * @param run Routine of the task.
+   * @param period Period (ms).
+   * @param first Time to the first run (ms).
+   * @return Id of the task, -1 if the scheduler is full.
+   */
+  short every(const char *name, void (*run)(), unsigned long period, unsigned long first = 0) {
+    short id = add(name, run, period);
+    start(id, first);
+    return id;
+  }
+
+  /**
+   * @brief Arms a task, or moves its next run. A task may re-arm itself from its routine.
+   * @param id Id of the task.
+   * @param delay Time to the run (ms).
+   */
+  void start(short id, unsigned long delay) {
+    if (id < 0 or id >= count) return;
+    tasks[id].due = millis() + delay;
+    tasks[id].armed = true;
+  }
+
+  /**
+   * @brief Disarms a task.
+   * @param id Id of the task.
+   */
+  void stop(short id) {
+    if (id >= 0 and id < count) tasks[id].armed = false;
+  }
+
+  /**
+   * @brief Runs the due tasks. A periodic task that has missed periods runs once.
+   */
+  void service() {
+    unsigned long now = millis();
+    for (unsigned char i = 0; i < count; i++) {
+      ScheduledTask &t = tasks[i];
+      if (!t.armed or (long)(now - t.due) < 0) continue;
+      if (t.period == 0) t.armed = false;
+      else {
+        t.due += t.period;
+        if ((long)(now - t.due) >= 0) t.due = now + t.period; // Late, keep the rate.
+      }
+
+      unsigned long start = micros();
+      t.run();
+      unsigned long elapsed = micros() - start;
+      t.runs++;
+      t.totalUs += elapsed;
+      t.maxUs = max(t.maxUs, elapsed);
+    }
+  }
+
+  /**
+   * @brief Gets the time to the next deadline.
+   * @return Time to the earliest armed task (ms), 0 if one is due, SCHEDULER_MAX_IDLE_MS at most.
+   */
+  unsigned long untilNext() const {
+    unsigned long now = millis();
+    unsigned long next = SCHEDULER_MAX_IDLE_MS;
+    for (unsigned char i = 0; i < count; i++) {
+      if (!tasks[i].armed) continue;
+      long left = (long)(tasks[i].due - now);
+      next = min(next, left > 0 ? (unsigned long)left : 0ul);
+    }
+    return next;
+  }
+
+  /**
+   * @brief Light-sleeps until the next deadline. For a loop with nothing else to do.
+   */
+  void idle() const {
+    unsigned long ms = untilNext();
+    if (ms == 0) return;
+    esp_sleep_enable_timer_wakeup(ms * 1000ull);
+    esp_light_sleep_start();
+  }
+
+  /**
+   * @brief Gets a task, for its statistics.
+   * @param id Id of the task.
+   * @return The task.
+   */
+  const ScheduledTask &task(short id) const {
+    return tasks[id];
+  }
+
+  /**
+   * @brief Prints the runs and run time of each task.
+   * @param out Output, e.g. Serial.
+   */
+  void printStats(Print &out) const {
+    for (unsigned char i = 0; i < count; i++) {
+      const ScheduledTask &t = tasks[i];
+      out.print(t.name);
+      out.print(F(": "));
+      out.print(t.runs);
+      out.print(F(" runs, mean "));
+      out.print(t.runs > 0 ? t.totalUs / t.runs : 0ul);
+      out.print(F(" us, max "));
+      out.print(t.maxUs);
+      out.println(F(" us"));
+    }
+  }
+};
+
+// ---------- Globals --------------
+Scheduler scheduler; /**< Scheduler of the main loop. */
@@ -0,0 +1,226 @@
+/**
+ * @file serialFrame.h
+ * @brief Framing of the binary Serial streams
+ *
+ * This file contains the framing shared by the binary streams sent over Serial. Each frame
+ * is self-delimited and checked, so the binary frames can share the port with the text
+ * reports of the debug mode and a reader can join the stream at any point:
+ *
+ *   sync (0xA5 0x5A) | type (1) | length (2) | payload (length) | CRC-16 (2)
+ *
+ * Multi-byte fields are little endian. The CRC (CCITT, 0xFFFF seed) covers type, length
+ * and payload. A reader that finds a bad CRC drops the frame and searches the next sync.
+ *
+ * The reader (SerialFrameReader) only needs the standard library, the host decoders use it
+ * with SERIAL_FRAME_FORMAT_ONLY defined.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ---------- Constants --------------
+/**
+ * @brief Sync bytes that start a frame.
+ */
+const uint8_t SERIAL_FRAME_SYNC[2] = {0xA5, 0x5A};
+
+/**
+ * @brief Bytes of a frame besides the payload: sync, type, length and CRC.
+ */
+const unsigned char SERIAL_FRAME_OVERHEAD = 7;
+
+/**
+ * @brief Largest payload of a frame.
+ */
+const uint16_t SERIAL_FRAME_MAX_PAYLOAD = 1024;
+
+/**
+ * @brief Types of frame.
+ */
+typedef enum {
+  SERIAL_FRAME_CYCLES = 1,   ///< Cycle histograms of the hot path, see cycleTelemetry.h
+  SERIAL_FRAME_SPECTRUM = 2, ///< Quantized spectrum of a capture, see spectrumStream.h
+} SerialFrameType;
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Updates a CRC-16/CCITT with a block of bytes.
+ * @param data The bytes.
+ * @param size Number of bytes.
+ * @param crc CRC of the previous bytes, 0xFFFF for the first block.
+ * @return The CRC.
+ */
+uint16_t crc16(const uint8_t *data, size_t size, uint16_t crc = 0xFFFF);
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Little endian writer of a payload over a fixed buffer.
+ */
+struct PayloadWriter {
+  uint8_t *data; /**< The buffer. */
+  uint16_t size; /**< Bytes of the buffer. */
+  uint16_t length; /**< Bytes written. */
+
+  /**
+   * @brief Appends an unsigned integer, dropped if it doesn't fit.
+   * @param value The value.
+   * @param bytes Bytes of the field.
+   */
+  void put(uint64_t value, unsigned char bytes) {
+    if (length + bytes > size) return;
+    for (unsigned char i = 0; i < bytes; i++) data[length++] = (uint8_t)(value >> (8 * i));
+  }
+
+  void u8(uint8_t value) { put(value, 1); }
+  void u16(uint16_t value) { put(value, 2); }
+  void u32(uint32_t value) { put(value, 4); }
+  void u64(uint64_t value) { put(value, 8); }
+};
+
+/**
+ * @brief Little endian reader of a payload.
+ */
+struct PayloadReader {
+  const uint8_t *data; /**< The payload. */
+  uint16_t length; /**< Bytes of the payload. */
+  uint16_t position; /**< Next byte to read. */
+  bool overrun; /**< True if a read went past the payload. */
+
+  /**
+   * @brief Reads an unsigned integer, 0 past the end of the payload.
+   * @param bytes Bytes of the field.
+   * @return The value.
+   */
+  uint64_t get(unsigned char bytes) {
+    if (position + bytes > length) {
+      overrun = true;
+      position = length;
+      return 0;
+    }
+    uint64_t value = 0;
+    for (unsigned char i = 0; i < bytes; i++) value |= (uint64_t)data[position++] << (8 * i);
+    return value;
+  }
+
+  uint8_t u8() { return get(1); }
+  uint16_t u16() { return get(2); }
+  uint32_t u32() { return get(4); }
+  uint64_t u64() { return get(8); }
+};
+
+// ---------- Class Definition --------------
+/**
+ * @class SerialFrameReader
+ * @brief Byte by byte parser of the frames of a stream.
+ */
+class SerialFrameReader {
+private:
+  uint8_t header[3]; /**< Type and length of the frame being read. */
+  uint8_t payload[SERIAL_FRAME_MAX_PAYLOAD]; /**< Payload of the frame being read. */
+  uint8_t crc[2]; /**< CRC of the frame being read. */
+  unsigned short position = 0; /**< Bytes of the frame read, sync included. */
+  uint16_t length = 0; /**< Length of the frame being read. */
+  unsigned long dropped = 0; /**< Frames with a bad CRC or length. */
+
+public:
+  /**
+   * @brief Feeds a byte of the stream.
+   * @param c The byte.
+   * @return True if the byte completes a valid frame, see type() and data().
+   */
+  bool feed(uint8_t c) {
+    if (position < 2) { // Search the sync.
+      if (c == SERIAL_FRAME_SYNC[position]) position++;
+      else position = (c == SERIAL_FRAME_SYNC[0]) ? 1 : 0;
+      return false;
+    }
+    if (position < 5) {
+      header[position - 2] = c;
+      position++;
+      if (position == 5) {
+        length = header[1] | (header[2] << 8);
+        if (length > SERIAL_FRAME_MAX_PAYLOAD) {
+          dropped++;
+          position = 0;
+        }
+      }
+      return false;
+    }
+    if (position < 5 + length) {
+      payload[position - 5] = c;
+      position++;
+      return false;
+    }
+    crc[position - 5 - length] = c;
+    position++;
+    if (position < 7 + length) return false;
+
+    position = 0;
+    uint16_t expected = crc16(payload, length, crc16(header, sizeof(header)));
+    if ((crc[0] | (crc[1] << 8)) == expected) return true;
+    dropped++;
+    return false;
+  }
+
+  /**
+   * @brief Gets the type of the last frame.
+   * @return The type.
+   */
+  uint8_t type() const {
+    return header[0];
+  }
+
+  /**
+   * @brief Gets a reader of the payload of the last frame.
+   * @return The reader.
+   */
+  PayloadReader data() const {
+    return PayloadReader{payload, length, 0, false};
+  }
+
+  /**
+   * @brief Gets the number of frames dropped.
+   * @return Frames with a bad CRC or length.
+   */
+  unsigned long droppedFrames() const {
+    return dropped;
+  }
+};
+
+// ---------- Code --------------
+uint16_t crc16(const uint8_t *data, size_t size, uint16_t crc) {
+  for (size_t i = 0; i < size; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (unsigned char b = 0; b < 8; b++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+// Host tools only need the format above.
+#ifndef SERIAL_FRAME_FORMAT_ONLY
+
+#include "Arduino.h"
+
+/**
+ * @brief Sends a frame.
+ * @param out Output stream, usually Serial.
+ * @param type Type of the frame.
+ * @param payload The payload.
+ * @param length Bytes of the payload, up to SERIAL_FRAME_MAX_PAYLOAD.
+ */
+void writeSerialFrame(Print &out, uint8_t type, const uint8_t *payload, uint16_t length) {
+  uint8_t header[5] = {SERIAL_FRAME_SYNC[0], SERIAL_FRAME_SYNC[1], type, (uint8_t)length, (uint8_t)(length >> 8)};
+  uint16_t crc = crc16(payload, length, crc16(header + 2, 3));
+  uint8_t trailer[2] = {(uint8_t)crc, (uint8_t)(crc >> 8)};
+  out.write(header, sizeof(header));
+  out.write(payload, length);
+  out.write(trailer, sizeof(trailer));
+}
+
+#endif
@@ -36,6 +36,9 @@
  * - Arduino Libraries: https://www.arduino.cc/reference/en/libraries/
  ******************************************************************************************/
 
+// Uncomment to send the cycle histograms of the hot path over Serial, see cycleTelemetry.h.
+// #define CYCLE_TELEMETRY
+
 #include "Arduino.h"
 #include "board.h"
 #include "display.h"
@@ -51,6 +54,13 @@ unsigned long lastActivity;
 // Tools section: Tools for sound analysis. Press 'P' and release the button when the microphone icon is displayed to enter and switch between modes.
 #include "soundAnalysisTools.h" // Analysis mode selection and title display
 
+// Periodic tasks globals, see scheduler.h
+const unsigned long BATTERY_PERIOD = 1000ul; // Battery sampling period (ms).
+const unsigned long EVENT_LOG_PERIOD = 1000ul; // Event log writing period (ms), as the writer task of the device.
+const unsigned long STATS_PERIOD = 10000ul; // Task statistics period in debug mode (ms).
+bool batteryLow = false;
+short sleepTask;
+
 
 /**
  * @brief Prints a low battery alert on the OLED display.
@@ -58,11 +68,31 @@ unsigned long lastActivity;
 void printLowBatteryAlert();
 
 /**
- * @brief Handles the activity logic of the program, including button presses, sound analysis,
- * and entering sleep mode.
+ * @brief Handles the activity logic of the program, including button presses and sound analysis.
  */
 void activityLogic();
 
+/**
+ * @brief Samples the battery, the battery task.
+ */
+void sampleBattery();
+
+/**
+ * @brief Enters sleep mode once the awake duration has passed since the last activity, the
+ * sleep task. Re-arms itself while there is activity.
+ */
+void sleepTimeout();
+
+/**
+ * @brief Sends the cycle histograms of the hot path, the telemetry task.
+ */
+void sendCycleReport();
+
+/**
+ * @brief Prints the run time of the tasks in debug mode, the statistics task.
+ */
+void printTaskStats();
+
 /**
  * @brief Sets up the initial configuration of the program. This includes board initialization,
  * display initialization, variable initialization, and verifying the wake-up reason.
@@ -70,8 +100,8 @@ void activityLogic();
 void setup();
 
 /**
- * @brief The main loop of the program. It handles the activity logic based on the battery status
- * and triggers low battery alerts when necessary.
+ * @brief The main loop of the program. It runs the due tasks and handles the activity logic based
+ * on the battery status, or shows the low battery alert and sleeps until the next task.
  */
 void loop();
 
@@ -79,34 +109,53 @@ void loop();
 void printLowBatteryAlert() {
   // Low battery alert
   display.clearDisplay();
-  delay(500);
   short x = (DISPLAY_WIDTH - low_battery_img.getWidth()) / 2;
   short y = (DISPLAY_HEIGHT - low_battery_img.getHeight()) / 2;
   display.drawXBitmap(x, y, low_battery_img.getData(), low_battery_img.getWidth(), low_battery_img.getHeight(), SSD1306_WHITE);
   display.display();
-  delay(500);
 }
 
 void activityLogic() {  
   static bool toolSection = false;
 
-  if (millis() - lastActivity < awakeDuration) { 
-    checkButton();
-    toolSection = toolSection or changeMode;
-    if (!toolSection) {
-      listen(currentMode, debug, lastActivity, awakeDuration);
-      currentMode = -1;
-    } else {
-      toolSection = true;
-      selectDisplayMode();
-    }
-  } else goToSleep();
+  checkButton();
+  toolSection = toolSection or changeMode;
+  if (!toolSection) {
+    listen(currentMode, debug, lastActivity, awakeDuration);
+    currentMode = -1;
+  } else {
+    toolSection = true;
+    selectDisplayMode();
+  }
+}
+
+void sampleBattery() {
+  batteryLow = analogRead(BATTERY_PIN) == 0;
+}
+
+void sleepTimeout() {
+  unsigned long awake = millis() - lastActivity;
+  if (awake < (unsigned long)awakeDuration) {
+    scheduler.start(sleepTask, awakeDuration - awake); // Activity since the task was armed.
+    return;
+  }
+  flushEventLog(); // Queued events are lost in deep sleep.
+  goToSleep();
+}
+
+void sendCycleReport() {
+  CYCLE_REPORT(Serial);
+}
+
+void printTaskStats() {
+  scheduler.printStats(Serial);
 }
 
 
 void setup() {
   //------------- Board initialization ------------------
   initBoard();
+  initButton();
 
   //------------- Display initialization ----------------------
   initDisplay();
@@ -114,13 +163,28 @@ void setup() {
   //----------- Initialize variables ---------------
   initSoundAnalysisTools();
   initAlerts();  
+  initEventLog();
 
   //------------- Verify wake up reason ----------------
   if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_EXT0) goToSleep();
   else lastActivity = millis();
+
+  //------------- Periodic tasks ----------------
+  scheduler.every("battery", sampleBattery, BATTERY_PERIOD);
+  sleepTask = scheduler.add("sleep", sleepTimeout);
+  scheduler.start(sleepTask, 0); // Arms itself from lastActivity.
+  scheduler.every("eventlog", serviceEventLog, EVENT_LOG_PERIOD);
+#ifdef CYCLE_TELEMETRY
+  scheduler.every("cycles", sendCycleReport, CYCLE_REPORT_MS, CYCLE_REPORT_MS);
+#endif
+  if (debug) scheduler.every("stats", printTaskStats, STATS_PERIOD, STATS_PERIOD);
 }
 
 void loop() {
-  if (analogRead(BATTERY_PIN)) activityLogic();
-  else printLowBatteryAlert();
+  scheduler.service();
+  if (!batteryLow) activityLogic();
+  else {
+    printLowBatteryAlert();
+    scheduler.idle(); // Nothing to analyze until the next task.
+  }
 }
@@ -12,12 +12,22 @@
 
 #include "board.h"
 #include "display.h"
+#include "textOverlay.h"
+#include "buttonInput.h"
+#include "scheduler.h"
+#include "cycleTelemetry.h"
 
 // Display libraries
 #include "soundInfo.h"
 #include "rawDisplays.h" // Analysis display modes
 #include "spectrumDisplays.h"
 #include "spectrogramDisplays.h"
+#include "octaveBands.h"
+#include "soundLevel.h"
+#include "tuner.h"
+#include "psdDisplay.h"
+#include "spectrumStream.h"
+#include "modeRegistry.h"
 
 // Namespaces
 #include "soundAnalysisToolsNamespaces.h"
@@ -25,29 +35,64 @@ using namespace commonSoundAnalysisTools;
 using namespace minMax;
 
 // Globals
-const unsigned char MAXMODES = 10;
+const unsigned long TOOL_ALERT_HOLD = 2000ul; /**< Time an alert is shown over a tool mode (ms). */
+const unsigned long TITLE_DURATION = 2000ul; /**< Time the title of a new mode is shown (ms). */
+
+/**
+ * @brief Tool modes, in button order. A new mode only needs an entry here.
+ */
+constexpr DisplayMode MODES[] = {
+  displayMode<SoundInfoState, initSoundInfo, displaySoundInfo>(nullptr),
+  displayMode<SoundInfoState, initSoundInfo, displaySoundFeatures>(nullptr),
+  displayMode<SpectrumState, initSpectrumVLines, displaySpectrum>("Spectrum", "Vertical Lines"),
+  displayMode<SpectrumState, initSpectrumContinuousLine, displaySpectrum>("Spectrum", "Continuous Line"),
+  displayMode<SpectrumState, initSpectrumLogFrequency, displaySpectrum>("Spectrum", "Log Frequency"),
+  displayMode<SpectrumState, initSpectrumMel, displaySpectrum>("Spectrum", "Mel"),
+  displayMode<SpectrumBarsState, initSpectrumBars, displaySpectrumBars>("Spectrum Bars"),
+  displayMode<AmplitudeBarsState, initAmplitudeBars, displayAmplitudeBars>("Amplitude Bars"),
+  displayMode<SweepingEnvelopeState, initSweepingEnvelope, displaySweepingEnvelope>("Sweeping", "Envelope"),
+  displayMode<RunningEnvelopeState, initRunningEnvelope, displayRunningEnvelope>("Running", "Envelope"),
+  displayMode<SecondSpectrogramState, initSpectrogram, displaySpectrogram>("1 Second", "Spectrogram"),
+  displayMode<SweepingSpectrogramState, initSweepingSpectrogram, displaySweepingSpectrogram>("Sweeping", "Spectrogram"),
+  displayMode<RunningSpectrogramState, initRunningSpectrogram, displayRunningSpectrogram>("Running", "Spectrogram"),
+  displayMode<OctaveBandsState, initOctaveBands, displayOctaveBands>("Octave", "Bands"),
+  displayMode<OctaveBandsState, initThirdOctaveBands, displayOctaveBands>("Third Octave", "Bands"),
+  displayMode<SoundLevelState, initSoundLevel, displaySoundLevel>("Sound Level", "Meter"),
+  displayMode<TunerState, initTuner, displayTuner>("Tuner"),
+  displayMode<PsdState, initPsdShort, displayPsd>("Welch PSD", "8 Averages"),
+  displayMode<PsdState, initPsdLong, displayPsd>("Welch PSD", "32 Averages"),
+  displayMode<SpectrumStreamState, initSpectrumStream, displaySpectrumStream>("Spectrum", "Stream"),
+};
+const unsigned char MAXMODES = sizeof(MODES) / sizeof(MODES[0]);
+ModeRunner<largestModeState(MODES, MAXMODES)> modeRunner; /**< State of the active mode, sized for the largest one. */
 short currentMode = 0;
 bool changeMode = false;
-unsigned long displayTitle[MAXMODES];
+unsigned long displayTitle; /**< Time the title of the current mode was shown, 0 if hidden. */
+short titleTask; /**< Scheduler task that hides the title. */
 
 
 /**
  * @brief Initialize the sound analysis tools.
  *
  * @details This function initializes the variables used by the sound analysis tools.
- * It sets default values for various parameters and flags.
+ * It sets default values for various parameters and flags and registers the title task
+ * in the scheduler.
  */
 void initSoundAnalysisTools();
 
 /**
  * @brief Show the title on the display.
  *
- * @details This function displays the title of the current mode on the display for a
- * specific duration. After the duration has elapsed, the title is cleared
- * from the display.
+ * @details This function shows the title of the current mode for TITLE_DURATION ms. The
+ * title task of the scheduler (hideTitle()) clears it from the display afterwards.
  */
 void showTitle();
 
+/**
+ * @brief Hide the title, the title task of the scheduler.
+ */
+void hideTitle();
+
 /**
  * @brief Print the title lines on the display.
  *
@@ -62,46 +107,48 @@ void printTitle(bool black);
 /**
  * @brief Check the physical button action.
  *
- * @details This function checks the state of the physical button and performs actions
- * based on the button press. If the button is pressed, it changes the display mode.
+ * @details This function takes the button events latched by the interrupt (see
+ * buttonInput.h) and goes to the next display mode on each click (release). It clears the
+ * cancellation of the analysis of the previous frame.
  */
 void checkButton();
 
 /**
  * @brief Select the display mode.
  *
- * @details This function selects the appropriate display mode based on the current mode
- * value. It calls the corresponding display function for the selected mode.
+ * @details This function captures a frame on the spectrum bus, checks it for alerts and runs
+ * a step of the current mode with it. On a mode change the state of the previous mode is
+ * released and the new mode is initialized. An alert is shown over the mode for
+ * TOOL_ALERT_HOLD ms, then the mode is entered again.
  */
 void selectDisplayMode();
 
 
 
 void initSoundAnalysisTools() {
-  for (unsigned char i = 0; i < MAXMODES; i++) {
-    displayTitle[i] = 0;
-  }
-  
-  displayTitle[0] = millis();
+  titleTask = scheduler.add("title", hideTitle);
+  showTitle();
 }
 
 void showTitle() {
-  static unsigned long timeDisplayTitle = 2000ul;
+  displayTitle = millis();
+  scheduler.start(titleTask, TITLE_DURATION);
+}
 
-  if (displayTitle[currentMode] > 0ul) {
-    if ((millis() - displayTitle[currentMode]) > timeDisplayTitle) {
-      displayTitle[currentMode] = 0ul;
-    } 
-  } 
+void hideTitle() {
+  displayTitle = 0ul;
 }
 
 void printTitle(bool black) {
+  if (modeRunner.current() == nullptr) return;
+  const char *const *title = modeRunner.current()->title;
+
   // Default Adafruit font 9x5 pixels.
   int nTitles = 0;
-  for (int i = 0; i < 7; i++) if (title[i].length() > 0) nTitles++;
+  for (int i = 0; i < MODE_TITLE_LINES; i++) if (title[i] != nullptr) nTitles++;
   int y = (display.height() / 2) - ((FONT_HEIGHT * nTitles) / 2);
   for (int i = 0; i < nTitles; ++i) {
-    int x = (display.width() / 2) - ((FONT_WIDTH * title[i].length()) / 2);
+    int x = (display.width() / 2) - ((FONT_WIDTH * strlen(title[i])) / 2);
     display.setCursor(x, y + (i * FONT_HEIGHT)) ;
     display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
     if (black) display.setTextColor(SSD1306_BLACK, SSD1306_BLACK);
@@ -110,74 +157,78 @@ void printTitle(bool black) {
 }
 
 void checkButton() {
-  static unsigned long chronoButton = millis();
-  static bool buttonStatus = digitalRead(BUTTON_P_PIN);
-  
   changeMode = false;
-  // Push the button to change modes
-  if (millis() - chronoButton > 500ul) {    
-    if (buttonStatus != digitalRead(BUTTON_P_PIN) && buttonStatus == LOW) { // Modes up
-      delay(30);
-      currentMode = (currentMode + 1) % MAXMODES;
-      changeMode = true;
-      chronoButton = millis();
-      awakeDuration = (2 * 60 * 1000); // Two minutes showing the current mode
-      lastActivity = millis();
-
-      // Clear title on change
-      for (unsigned char i = 0; i < 7; i++) title[i] = "";
-      displayTitle[currentMode] = millis();
-    }
-    buttonStatus = digitalRead(BUTTON_P_PIN);
+  analysisCancel.reset(); // A click from now on cancels the analysis of this frame.
+
+  // Click the button to change modes
+  ButtonEvent event;
+  while (nextButtonEvent(event)) {
+    if (event.type != BUTTON_RELEASE) continue;
+    currentMode = (currentMode + 1) % MAXMODES; // Modes up
+    changeMode = true;
+    awakeDuration = (2 * 60 * 1000); // Two minutes showing the current mode
+    lastActivity = millis();
+    showTitle(); // Show the title of the new mode.
   }
 }
 
 void selectDisplayMode() {
   static bool prevShowTitle = true;
+  static unsigned long alertShown = 0ul;
+  static bool holdingAlert = false;
+
+  if (currentMode < 0 or currentMode >= MAXMODES) return;
+  heapProbeStart();
+  governorStart(changeMode);
+
+  // The alerts are watched on the same capture the mode draws.
+  Pair<float, int> peak = analyzeSound();
+  if (spectrumBus::frame.cancelled) { // A click, the next loop enters the next mode.
+    heapProbeEnd();
+    return;
+  }
+  bool onset;
+  if (watchAlerts(peak.first, peak.second, onset)) {
+    lastActivity = millis();
+    awakeDuration = (2 * 60 * 1000); // 2 minutes showing alert
+    printAlert(debug);
+    latencyMark(LAT_RENDER);
+    if (onset) latencyAlert();
+    alertShown = millis();
+    holdingAlert = true;
+  }
+  latencyFrameEnd();
 
-  showTitle();
-  switch (currentMode) {
-    case 0: // Display spectrum 
-      displaySoundInfo();
-      break;
-    case 1: // Display spectrum 
-      displaySpectrum(changeMode, 0);
-      break;
-    case 2: // Display spectrum 
-      displaySpectrum(changeMode, 1);
-      break;
-    case 3: // Display spectrum bars        
-      displaySpectrumBars(changeMode);
-      break;
-    case 4: // Display Amplitude bars
-      displayAmplitudeBars(changeMode);
-      break;
-    case 5: // Display Sweeping Envelope
-      displaySweepingEnvelope(changeMode);
-      break;
-    case 6: // Display Running Envelope
-      displayRunningEnvelope(changeMode);
-      break;
-    case 7: // Display 1s Spectrogram
-      displaySpectrogram(changeMode);
-      break;
-    case 8: // Display Sweeping Spectrogram
-      displaySweepingSpectrogram(changeMode);      
-      break;
-    case 9: // Display Running Spectrogram
-      displayRunningSpectrogram(changeMode);
-      break;
-    default:
-      break;
+  if (holdingAlert and !changeMode and millis() - alertShown < TOOL_ALERT_HOLD) {
+    if (governorEnd() and debug) printFrameRates(Serial);
+    heapProbeEnd();
+    return;
   }
+  bool reenter = holdingAlert; // The alert has drawn over the mode.
+  holdingAlert = false;
+
+  if (changeMode or reenter or modeRunner.current() != &MODES[currentMode]) modeRunner.enter(MODES[currentMode]);
+  CYCLE_BEGIN(CYC_MODE);
+  modeRunner.step(spectrumBus::frame);
+  CYCLE_END(CYC_MODE);
+
+  // Analysis may run several times per frame, the frame is sent at the target FPS.
+  if (governorRender()) {
+    if (displayTitle > 0ul) {
+      printTitle(false);
+      prevShowTitle = true;
+    } else if (prevShowTitle) {
+      prevShowTitle = false;
+      printTitle(true);
+    }
 
-  if (displayTitle[currentMode] > 0ul) {
-    printTitle(false);
-    prevShowTitle = true;
-  } else if (prevShowTitle) {
-    prevShowTitle = false;
-    printTitle(true);
+    display.display();
   }
+  if (governorEnd() and debug) printFrameRates(Serial);
 
-  display.display();
+  // Per-frame readouts must not allocate.
+  if (heapProbeEnd() > 0 and debug) {
+    Serial.print(F("Heap allocations in frame: "));
+    Serial.println(heapProbe::lastFrame);
+  }
 }
\ No newline at end of file
@@ -13,6 +13,8 @@
 
 #include "board.h"
 #include "fft.h"
+#include "frameGovernor.h"
+#include "spectrumBus.h"
 
 /**
  * @namespace commonSoundAnalysisTools
@@ -20,7 +22,6 @@
  */
 namespace commonSoundAnalysisTools {
   long chrono; /**< Chrono variable. */
-  String title[7] = {""}; /**< Title array. */
 }
 
 /**
@@ -46,39 +47,32 @@ namespace minMax {
  * @brief Namespace for common spectrum tools.
  */
 namespace commonSpectrum {
-  long chronoRead; /**< Chrono read variable. */
-  const unsigned char MAX_FREQ = 16; /**< Maximum frequency (kHz). */
-  unsigned long sampling_period_us = round(1000ul * (1.0 / MAX_FREQ)); /**< Sampling period in microseconds. */
+  const unsigned char MAX_FREQ = BUS_MAX_FREQ; /**< Maximum frequency (kHz). */
 
   /**
-   * @brief Acquires sound data.
+   * @brief Applies the window function and performs FFT on samples.
    *
-   * @details This function acquires sound data from an analog pin and stores it in the provided array.
-   *
-   * @param data Pointer to complex sound data.
-   * @param nSamples Number of samples to acquire.
+   * @param data Pointer to complex sound data array, replaced by the spectrum.
+   * @param log2Sample Log base 2 of the number of samples.
    */
-  void acquireSound(float _Complex *data, int nSamples) {
-    for (int i = 0; i < nSamples; i++) {
-      chronoRead = micros();
-      data[i] = analogRead(MIC_PIN);
-      while (micros() - chronoRead < sampling_period_us); // only if analogRead time < sampling_period_us
-    } // 12.8 ms
+  void transform(float _Complex *data, int log2Sample) {
+    applyWindow (data, log2Sample, HAMMING, FFT_FORWARD);
+    performFFT(data, log2Sample, FFT_FORWARD);    
   }
 
   /**
-   * @brief Gets sound data and performs FFT.
+   * @brief Gets a block of the last capture and performs FFT.
    *
-   * @details This function acquires sound data using `acquireSound()`, applies a window function,
-   * and performs the Fast Fourier Transform (FFT) on the acquired data.
+   * @details The sound comes from the spectrum bus, see spectrumBus.h.
    *
-   * @param data Pointer to complex sound data array.
-   * @param nSamples Number of samples to acquire and process.
+   * @param frame The last capture.
+   * @param from First sample of the block.
+   * @param data Pointer to complex sound data array, replaced by the spectrum.
+   * @param nSamples Number of samples of the block.
    * @param log2Sample Log base 2 of the number of samples.
    */
-  void getData(float _Complex *data, int nSamples, int log2Sample) {
-    acquireSound(data, nSamples);
-    applyWindow (data, log2Sample, HAMMING, FFT_FORWARD);
-    performFFT(data, log2Sample, FFT_FORWARD);    
+  void getData(const BusFrame &frame, unsigned short from, float _Complex *data, int nSamples, int log2Sample) {
+    for (int i = 0; i < nSamples; i++) data[i] = frame.samples[from + i];
+    transform(data, log2Sample);
   }
 }
\ No newline at end of file
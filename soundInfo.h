@@ -12,57 +12,71 @@
 #include "listenLogic.h"
 #include "display.h"
 #include "pair.h"
+#include "latencyStats.h"
+#include "textOverlay.h"
+#include "frameGovernor.h"
+#include "spectrumBus.h"
 
 // -------------- Listening global variables and constants ------------------
-const int LISTEN_SAMPLES = 1024;
+const int LISTEN_SAMPLES = BUS_SAMPLES;
 int maxCounter[LISTEN_SAMPLES] = {0};
 int bestThree[3] = {0,0,0};
+float meanA = 0; // Mean intensity of the last analyzed spectrum (noise floor for the SNR).
+
+// ---------------- Struct Definition ----------------------
+/**
+ * @brief State of the sound info mode, empty: its buffers are shared with the listening mode.
+ */
+struct SoundInfoState {};
 
 // ---------------- Headers ----------------------
 /**
- * @brief Displays the relevant information for the listening mode on the display.
+ * @brief Draws the relevant information for the listening mode, the caller sends the frame.
  * @param vOffset The vertical offset for displaying the information.
  * @param maxA The maximum amplitude value.
  * @param maxI The index corresponding to the maximum amplitude.
  */
-void showListeningInfo(short vOffset);
-
-/**
-* @brief Reads the sound data from the microphone.
-* @param data The array to store the sound data.
-*/
-void getSound(float _Complex *data);
+void showListeningInfo(short vOffset, float maxA, int maxI);
 
 /**
  * @brief Analyzes the sound data using Fast Fourier Transform (FFT).
- * @return A Pair object containing the maximum amplitude and its corresponding index.
+ *
+ * @details Captures a frame on the spectrum bus (see spectrumBus.h) and counts its peak.
+ *
+ * @return A Pair object containing the maximum amplitude and its corresponding index, {0, 0}
+ * if the capture was cancelled.
  */
 Pair<float, int> analyzeSound();
 
 /**
- * @brief Extracts the relevant information from the analyzed sound data.
- * @param data The analyzed sound data.
- * @param maxA Reference to store the maximum amplitude.
- * @param maxI Reference to store the index corresponding to the maximum amplitude.
+ * @brief Initializes the sound information mode, nothing to draw.
+ * @param state The mode state.
  */
-void getRellevantInfo(float _Complex *data, float &maxA, int &maxI);
+void initSoundInfo(SoundInfoState &state);
 
 /**
  * @brief Displays the sound information on the display.
+ * @param state The mode state.
+ * @param frame The last capture.
+ */
+void displaySoundInfo(SoundInfoState &state, const BusFrame &frame);
+
+/**
+ * @brief Displays the spectral features of the capture (see spectralFeatures.h), the second
+ * page of the sound information.
+ * @param state The mode state.
+ * @param frame The last capture.
  */
-void displaySoundInfo();
+void displaySoundFeatures(SoundInfoState &state, const BusFrame &frame);
 
 
 // ---------------- Code ----------------------
 void showListeningInfo(short vOffset, float maxA, int maxI) {  
+  TextLine text;
   display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
-  display.setCursor(0, vOffset + 0);
-  display.println("Mark: " + String(maxI));
-  display.setCursor(0, vOffset + FONT_HEIGHT);
-  display.println("AHz: " + String(maxA));
-  display.setCursor(0, vOffset + FONT_HEIGHT * 2);
-  display.println("Hz: " + String(maxI * 15.2256 * (1024.0 / LISTEN_SAMPLES)));
-  display.setCursor(0, vOffset + FONT_HEIGHT * 3);  
+  drawText(0, vOffset + 0, text.add("Mark: ").addInt(maxI).c_str());
+  drawText(0, vOffset + FONT_HEIGHT, text.clear().add("AHz: ").addFixed(maxA).c_str());
+  drawText(0, vOffset + FONT_HEIGHT * 2, text.clear().add("Hz: ").addFixed(maxI * 15.2256 * (1024.0 / LISTEN_SAMPLES)).c_str());
   
   if (maxA > 20000) {
     int i = 30;
@@ -78,72 +92,58 @@ void showListeningInfo(short vOffset, float maxA, int maxI) {
         } else if (maxCounter[i] > maxCounter[bestThree[2]] and bestThree[0] != i and bestThree[1] != i) bestThree[2] = i;
       }    
       i++;
-      while (maxCounter[i] <= maxCounter[bestThree[2]] and i < LISTEN_SAMPLES) i++;
+      while (i < LISTEN_SAMPLES and maxCounter[i] <= maxCounter[bestThree[2]]) i++;
     }
   }
   
   
-  String txt = "";
+  text.clear().add("B3: ");
   for (int i = 0; i < 3; ++i) {
-    if (i > 0 and bestThree[i] > 0) txt += ", ";
-    if (bestThree[i] > 0) txt += String(bestThree[i]);     
+    if (i > 0 and bestThree[i] > 0) text.add(", ");
+    if (bestThree[i] > 0) text.addInt(bestThree[i]);     
   }
-  display.setCursor(0, vOffset + FONT_HEIGHT * 3);
-  display.println("B3: " + txt);
-  display.display();
+  drawText(0, vOffset + FONT_HEIGHT * 3, text.c_str());
   
 }
 
 
 // ---------------- Sound analyze ----------------------
-void getSound(float _Complex *data) {
-  static long chrono;
-  static const int LISTEN_MAX_FREQ = 16; // kHz
-  static const unsigned long sampling_period_us = round(1000ul * (1.0 / LISTEN_MAX_FREQ)); // 1/Hz = T(s) -> 1/kHz = T(ms)
-  
-  for (int i = 0; i < LISTEN_SAMPLES; i++) {
-    chrono = micros();
-    data[i] = analogRead(MIC_PIN);    
-    while (micros() - chrono < sampling_period_us); // only if analogRead time < sampling_period_us
-  }
-}
-
-void getRellevantInfo(float _Complex *data, float &maxA, int &maxI) {
-  maxA = 0;
-  maxI = 0;
-  for (int i = 1; i < LISTEN_SAMPLES; i++) {
-    if (creal(data[i]) > maxA) {
-      maxA = creal(data[i]);
-      maxI = i;    
-    }
-  }
-  maxCounter[maxI]++;
-  
-}
-
 Pair<float, int> analyzeSound() {
-  static float _Complex data[LISTEN_SAMPLES];
-  static const int log2Sample = log(LISTEN_SAMPLES) / log(2);
-  static float maxA = 0;
-  static int maxI = 0;
-  
-  getSound(data);   
-  applyWindow (data, log2Sample, HAMMING, FFT_FORWARD);
-  performFFT(data, log2Sample, FFT_FORWARD);
-  getRellevantInfo(data, maxA, maxI);
+  const BusFrame &frame = captureSpectrum();
+  if (frame.cancelled) return {0.0f, 0};
+  meanA = frame.meanA;
+  maxCounter[frame.peakI]++;
 
-  Pair<float, int> max = {maxA, maxI};
+  Pair<float, int> max = {frame.peakA, frame.peakI};
   return max;
 }
 
 
-void displaySoundInfo() {
-  Pair<float, int> maxVal = analyzeSound();
+void initSoundInfo(SoundInfoState &state) {}
+
+void displaySoundInfo(SoundInfoState &state, const BusFrame &frame) {
+  Pair<float, int> maxVal = {frame.peakA, frame.peakI};
+  if (!governorRender()) return;
 
   display.clearDisplay();
   display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
-  String txt = "Sound Info";
-  display.setCursor((DISPLAY_WIDTH - (txt.length() * FONT_WIDTH)) / 2, 0);
-  display.println("Sound Info");  
+  drawCenteredText(DISPLAY_WIDTH / 2, 0, "Sound Info");
   showListeningInfo(FONT_HEIGHT * 2, maxVal.first, maxVal.second);
+}
+
+void displaySoundFeatures(SoundInfoState &state, const BusFrame &frame) {
+  const SpectralFeatures &f = frame.features;
+  if (!governorRender()) return;
+
+  TextLine text;
+  display.clearDisplay();
+  display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+  drawCenteredText(DISPLAY_WIDTH / 2, 0, "Sound Features");
+  drawText(0, FONT_HEIGHT, text.add("Centroid: ").addInt(f.centroid).add(" Hz").c_str());
+  drawText(0, FONT_HEIGHT * 2, text.clear().add("Spread: ").addInt(f.spread).add(" Hz").c_str());
+  drawText(0, FONT_HEIGHT * 3, text.clear().add("Rolloff: ").addInt(f.rolloff).add(" Hz").c_str());
+  drawText(0, FONT_HEIGHT * 4, text.clear().add("Flat: ").addFixed(f.flatness).add(" Flux: ").addFixed(f.flux).c_str());
+  text.clear().add("L/M/H: ");
+  for (unsigned char b = 0; b < N_BANDS; b++) text.add(b > 0 ? "/" : "").addInt(round(f.bands[b] * 100));
+  drawText(0, FONT_HEIGHT * 5, text.add(" %").c_str());
 }
\ No newline at end of file
@@ -0,0 +1,299 @@
+/**
+ * @file soundLevel.h
+ * @brief A-weighted sound level meter mode
+ *
+ * This file contains the Sound Level Meter mode. Every sample of every capture of the
+ * spectrum bus goes through an A-weighting filter and its energy into the time weightings
+ * of a sound level meter, all in integer arithmetic:
+ * - A-weighting: a cascade of three biquads with Q28 coefficients, direct form I with 64 bit
+ *   accumulators. Two high-pass sections are the bilinear transform of the 20.6 Hz and
+ *   107.7 / 737.9 Hz poles of IEC 61672, the third section is a low-pass fitted to the
+ *   12194 Hz poles (above the Nyquist frequency of 8 kHz). Within 0.2 dB of the analog
+ *   curve from 20 Hz to 7.5 kHz, 0 dB at 1 kHz.
+ * - Fast (125 ms) and slow (1 s) time weightings: exponential means of the squared samples,
+ *   acc += y^2 - acc / 2^k, with 2^k samples as the time constant.
+ * - Leq: sum of the squared samples since the mode started.
+ * - Lmax: highest fast level since the mode started.
+ * The levels are converted to dB once per frame. The time constants count sampled time:
+ * the time the loop spends between two captures is not sampled by the bus.
+ *
+ * The levels are dB(A) with a calibration offset: the level of a full-scale sine. The
+ * default comes from the data sheets (MAX9814 at 60 dB of gain, -44 dBV/Pa capsule, 1.1 V
+ * RMS at the ADC full scale); the AGC of the MAX9814 compresses the loud sounds. To
+ * calibrate, play a known level (e.g. a 94 dB calibrator) in this mode and send
+ * "CAL 94" over Serial: the offset is set so the slow level reads it, and is kept in the
+ * NVS of the device.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "Arduino.h"
+#include "board.h"
+#include "display.h"
+#include "textOverlay.h"
+#include "frameGovernor.h"
+#include "spectrumBus.h"
+
+#ifdef ESP_PLATFORM
+#include <Preferences.h>
+#endif
+
+// ---------- Constants --------------
+/**
+ * @brief Fractional bits of the filter coefficients.
+ */
+const unsigned char SLM_COEF_BITS = 28;
+
+/**
+ * @brief Sections of the A-weighting filter.
+ */
+const unsigned char SLM_SECTIONS = 3;
+
+/**
+ * @brief A-weighting biquads at 16 kHz, Q28: b0, b1, b2, a1, a2 (a0 = 1).
+ */
+const int32_t SLM_A_WEIGHTING[SLM_SECTIONS][5] = {
+  {266277129, -532554258, 266277129, -532545546, 264127514}, // 20.6 Hz double pole
+  {229612791, -459225582, 229612791, -457819256, 192196451}, // 107.7 and 737.9 Hz poles
+  {294338165, 147169083, 18396135, 91268055, 7757785},       // 12194 Hz poles, gain of 0 dB at 1 kHz
+};
+
+/**
+ * @brief Fractional bits of the filter input: the samples are scaled up so the rounding of
+ * the sections stays under the ADC resolution.
+ */
+const unsigned char SLM_INPUT_BITS = 4;
+
+/**
+ * @brief Time constant of the fast weighting, 2^11 samples (128 ms).
+ */
+const unsigned char SLM_FAST_SHIFT = 11;
+
+/**
+ * @brief Time constant of the slow weighting, 2^14 samples (1.02 s).
+ */
+const unsigned char SLM_SLOW_SHIFT = 14;
+
+/**
+ * @brief Level of the mean square of a full-scale sine (ADC amplitude of 2048) at the filter output (dB).
+ */
+const float SLM_FULL_SCALE_DB = 87.3f;
+
+/**
+ * @brief Default calibration offset: dB SPL of a full-scale sine.
+ */
+const float SLM_DEFAULT_OFFSET_DB = 79.0f;
+
+const float SLM_BAR_FROM_DB = 30.0f; /**< Level of the empty level bar (dB(A)). */
+const float SLM_BAR_TO_DB = 110.0f; /**< Level of the full level bar (dB(A)). */
+
+/**
+ * @brief Capacity of a Serial command line.
+ */
+const unsigned char SLM_COMMAND_CAPACITY = 16;
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Biquad section in direct form I.
+ */
+struct Biquad {
+  const int32_t *c; /**< b0, b1, b2, a1, a2, Q28. */
+  int32_t x1, x2; /**< Last inputs. */
+  int32_t y1, y2; /**< Last outputs. */
+
+  /**
+   * @brief Filters a sample.
+   * @param x The input.
+   * @return The output.
+   */
+  int32_t step(int32_t x) {
+    int64_t acc = (int64_t)c[0] * x + (int64_t)c[1] * x1 + (int64_t)c[2] * x2
+                - (int64_t)c[3] * y1 - (int64_t)c[4] * y2;
+    int32_t y = (acc + (1ll << (SLM_COEF_BITS - 1))) >> SLM_COEF_BITS;
+    x2 = x1;
+    x1 = x;
+    y2 = y1;
+    y1 = y;
+    return y;
+  }
+};
+
+/**
+ * @brief State of the sound level meter mode.
+ */
+struct SoundLevelState {
+  Biquad sections[SLM_SECTIONS]; /**< A-weighting filter. */
+  uint64_t fast; /**< Fast mean square, scaled by 2^SLM_FAST_SHIFT. */
+  uint64_t slow; /**< Slow mean square, scaled by 2^SLM_SLOW_SHIFT. */
+  uint64_t fastMax; /**< Highest fast mean square, scaled as fast. */
+  uint64_t energy; /**< Sum of the squares since the mode started. */
+  uint64_t samples; /**< Samples since the mode started. */
+  char command[SLM_COMMAND_CAPACITY]; /**< Serial command being received. */
+  unsigned char commandLength; /**< Characters of the command. */
+};
+
+/**
+ * @namespace soundLevel
+ * @brief Namespace for the calibration of the sound level meter.
+ */
+namespace soundLevel {
+  float offset = SLM_DEFAULT_OFFSET_DB; /**< Calibration offset (dB). */
+  bool loaded = false; /**< True once offset has been read from the storage. */
+}
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Reads the calibration offset from the NVS, once. The host keeps it in RAM.
+ */
+void loadLevelCalibration();
+
+/**
+ * @brief Sets the calibration offset and stores it in the NVS.
+ * @param offset Calibration offset (dB).
+ */
+void saveLevelCalibration(float offset);
+
+/**
+ * @brief Converts a mean square of the filter output to dB(A).
+ * @param meanSquare The mean square.
+ * @return The level (dB(A)).
+ */
+float levelDb(float meanSquare);
+
+/**
+ * @brief Runs the samples of a capture through the filter and the time weightings.
+ * @param state The mode state.
+ * @param samples ADC samples.
+ * @param n Number of samples.
+ */
+void measureLevel(SoundLevelState &state, const short *samples, unsigned short n);
+
+/**
+ * @brief Reads the Serial commands of the mode: "CAL <dB>" calibrates to the slow level.
+ * @param state The mode state.
+ */
+void readLevelCommands(SoundLevelState &state);
+
+/**
+ * @brief Initializes the sound level meter: loads the calibration and sets up the filter.
+ * @param state The mode state.
+ */
+void initSoundLevel(SoundLevelState &state);
+
+/**
+ * @brief Measures the capture and, when a frame is due, shows the levels.
+ * @param state The mode state.
+ * @param frame The last capture.
+ */
+void displaySoundLevel(SoundLevelState &state, const BusFrame &frame);
+
+// ---------- Code --------------
+void loadLevelCalibration() {
+  if (soundLevel::loaded) return;
+  soundLevel::loaded = true;
+#ifdef ESP_PLATFORM
+  Preferences preferences;
+  if (preferences.begin("soundLevel", true)) {
+    soundLevel::offset = preferences.getFloat("offset", SLM_DEFAULT_OFFSET_DB);
+    preferences.end();
+  }
+#endif
+}
+
+void saveLevelCalibration(float offset) {
+  soundLevel::offset = offset;
+#ifdef ESP_PLATFORM
+  Preferences preferences;
+  if (preferences.begin("soundLevel", false)) {
+    preferences.putFloat("offset", offset);
+    preferences.end();
+  }
+#endif
+}
+
+float levelDb(float meanSquare) {
+  if (meanSquare < 1) meanSquare = 1; // Under the rounding of the filter.
+  return 10.0f * log10f(meanSquare) - SLM_FULL_SCALE_DB + soundLevel::offset;
+}
+
+void measureLevel(SoundLevelState &state, const short *samples, unsigned short n) {
+  Biquad &s0 = state.sections[0];
+  Biquad &s1 = state.sections[1];
+  Biquad &s2 = state.sections[2];
+  uint64_t fast = state.fast, slow = state.slow, fastMax = state.fastMax, energy = 0;
+  for (unsigned short i = 0; i < n; i++) {
+    int32_t y = s2.step(s1.step(s0.step((int32_t)(samples[i] - SILENCE) << SLM_INPUT_BITS)));
+    uint64_t square = (int64_t)y * y;
+    fast += square - (fast >> SLM_FAST_SHIFT);
+    slow += square - (slow >> SLM_SLOW_SHIFT);
+    fastMax = fast > fastMax ? fast : fastMax;
+    energy += square;
+  }
+  state.fast = fast;
+  state.slow = slow;
+  state.fastMax = fastMax;
+  state.energy += energy;
+  state.samples += n;
+}
+
+void readLevelCommands(SoundLevelState &state) {
+  while (Serial.available() > 0) {
+    char c = Serial.read();
+    if (c != '\n' and c != '\r') {
+      if (state.commandLength < SLM_COMMAND_CAPACITY - 1) state.command[state.commandLength++] = c;
+      continue;
+    }
+    state.command[state.commandLength] = '\0';
+    if (strncmp(state.command, "CAL ", 4) == 0) {
+      float target = atof(state.command + 4);
+      float measured = levelDb((float)(state.slow >> SLM_SLOW_SHIFT));
+      saveLevelCalibration(soundLevel::offset + target - measured);
+      Serial.print(F("Calibration offset: "));
+      Serial.println(soundLevel::offset);
+    }
+    state.commandLength = 0;
+  }
+}
+
+void initSoundLevel(SoundLevelState &state) {
+  loadLevelCalibration();
+  for (unsigned char i = 0; i < SLM_SECTIONS; i++) state.sections[i].c = SLM_A_WEIGHTING[i];
+}
+
+void displaySoundLevel(SoundLevelState &state, const BusFrame &frame) {
+  measureLevel(state, frame.samples, BUS_SAMPLES);
+  readLevelCommands(state);
+  if (!governorRender()) return;
+
+  float fast = levelDb((float)(state.fast >> SLM_FAST_SHIFT));
+  float slow = levelDb((float)(state.slow >> SLM_SLOW_SHIFT));
+  float leq = levelDb((float)state.energy / state.samples);
+  float lmax = levelDb((float)(state.fastMax >> SLM_FAST_SHIFT));
+
+  TextLine text;
+  display.clearDisplay();
+  display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+  display.setTextSize(2);
+  drawText(0, 0, text.addFixed(fast, 1).c_str());
+  display.setTextSize(1);
+  drawText(DISPLAY_WIDTH - FONT_WIDTH * 7, FONT_HEIGHT / 2, "dB(A) F");
+  drawText(0, FONT_HEIGHT * 2, text.clear().add("Slow: ").addFixed(slow, 1).c_str());
+  drawText(0, FONT_HEIGHT * 3, text.clear().add("Leq: ").addFixed(leq, 1).add(" (").addInt(state.samples / (BUS_MAX_FREQ * 1000ul)).add(" s)").c_str());
+  drawText(0, FONT_HEIGHT * 4, text.clear().add("Lmax: ").addFixed(lmax, 1).c_str());
+  drawText(0, FONT_HEIGHT * 5, text.clear().add("Cal: ").addFixed(soundLevel::offset, 1).add(" dB").c_str());
+
+  // Fast level bar.
+  float fraction = (fast - SLM_BAR_FROM_DB) / (SLM_BAR_TO_DB - SLM_BAR_FROM_DB);
+  short width = fraction <= 0 ? 0 : (fraction >= 1 ? DISPLAY_WIDTH : fraction * DISPLAY_WIDTH);
+  display.drawFastHLine(0, DISPLAY_HEIGHT - 6, DISPLAY_WIDTH, SSD1306_WHITE);
+  display.drawFastHLine(0, DISPLAY_HEIGHT - 1, DISPLAY_WIDTH, SSD1306_WHITE);
+  display.drawFastVLine(0, DISPLAY_HEIGHT - 6, 6, SSD1306_WHITE);
+  display.drawFastVLine(DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 6, 6, SSD1306_WHITE);
+  display.fillRect(0, DISPLAY_HEIGHT - 6, width, 6, SSD1306_WHITE);
+}
@@ -0,0 +1,171 @@
+/**
+ * @file spectralFeatures.h
+ * @brief Spectral descriptors of a capture
+ *
+ * This file contains the descriptors of the shape of a spectrum used to tell sounds apart
+ * beyond the peak bin: centroid, spread, flatness, rolloff, band energy ratios and flux.
+ * They are computed in one pass over the bins of the capture with integer accumulators:
+ * magnitudes are truncated to integers, moments and energies add up in 64 bits and the
+ * logarithm of the flatness is a Q8 log2 (leading bit and 8 bits of mantissa). Only the
+ * final ratios are floats, a few divisions per capture.
+ *
+ *   centroid  magnitude-weighted mean frequency (Hz)
+ *   spread    magnitude-weighted standard deviation around the centroid (Hz)
+ *   flatness  geometric / arithmetic mean of the magnitudes: 0 for a pure tone, 1 for white noise
+ *   rolloff   frequency below which ROLLOFF_FRACTION of the energy lies (Hz)
+ *   bands     fraction of the energy below LOW_BAND_HZ, up to HIGH_BAND_HZ and above
+ *   flux      rise of the magnitudes since the previous capture, relative to their sum
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include <complex.h>
+
+// ---------- Constants --------------
+/**
+ * @brief Maximum number of bins of a spectrum.
+ */
+const unsigned short FEATURE_MAX_BINS = 512;
+
+/**
+ * @brief Bins of a rolloff band: the energy is accumulated per band and the rolloff
+ * interpolated inside the band that reaches the fraction.
+ */
+const unsigned char ROLLOFF_BAND_BINS = 16;
+
+/**
+ * @brief Fraction of the energy of the rolloff.
+ */
+const float ROLLOFF_FRACTION = 0.85f;
+
+/**
+ * @brief Upper limit of the low band (Hz).
+ */
+const float LOW_BAND_HZ = 500.0f;
+
+/**
+ * @brief Upper limit of the mid band (Hz).
+ */
+const float HIGH_BAND_HZ = 2000.0f;
+
+/**
+ * @brief Right shift of the magnitudes kept for the flux, so they fit in 16 bits.
+ */
+const unsigned char FLUX_SHIFT = 5;
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Energy bands of the band ratios.
+ */
+typedef enum {
+  BAND_LOW,  ///< Below LOW_BAND_HZ
+  BAND_MID,  ///< LOW_BAND_HZ to HIGH_BAND_HZ
+  BAND_HIGH, ///< Above HIGH_BAND_HZ
+  N_BANDS
+} FeatureBand;
+
+/**
+ * @brief Descriptors of a spectrum.
+ */
+struct SpectralFeatures {
+  float centroid; /**< Spectral centroid (Hz). */
+  float spread; /**< Spectral spread (Hz). */
+  float flatness; /**< Spectral flatness, 0 to 1. */
+  float rolloff; /**< Rolloff frequency (Hz). */
+  float bands[N_BANDS]; /**< Fraction of the energy of each band, they add up to 1. */
+  float flux; /**< Spectral flux, 0 on the first capture. */
+};
+
+/**
+ * @namespace spectralFeatures
+ * @brief Namespace for the state of the flux.
+ */
+namespace spectralFeatures {
+  uint16_t previous[FEATURE_MAX_BINS]; /**< Magnitudes of the previous capture, >> FLUX_SHIFT. */
+  bool primed = false; /**< True once previous holds a capture. */
+}
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Fixed-point logarithm.
+ * @param x The value, 0 is taken as 1.
+ * @return log2(x) in Q8.
+ */
+inline int32_t log2Q8(uint32_t x);
+
+/**
+ * @brief Computes the descriptors of a spectrum in one pass. Bin 0 (DC) is skipped.
+ * @param spectrum The spectrum, from 0 Hz.
+ * @param bins Bins up to the Nyquist frequency, FEATURE_MAX_BINS at most.
+ * @param hzPerBin Hz per bin.
+ * @param f Output: the descriptors.
+ */
+void extractFeatures(const float _Complex *spectrum, unsigned short bins, float hzPerBin, SpectralFeatures &f);
+
+// ---------- Code --------------
+inline int32_t log2Q8(uint32_t x) {
+  if (x <= 1) return 0;
+  int32_t n = 31 - __builtin_clz(x);
+  uint32_t mantissa = n >= 8 ? x >> (n - 8) : x << (8 - n);
+  return (n << 8) | (mantissa & 0xFF);
+}
+
+void extractFeatures(const float _Complex *spectrum, unsigned short bins, float hzPerBin, SpectralFeatures &f) {
+  bins = bins < FEATURE_MAX_BINS ? bins : FEATURE_MAX_BINS;
+  unsigned short lowBin = LOW_BAND_HZ / hzPerBin;
+  unsigned short highBin = HIGH_BAND_HZ / hzPerBin;
+  const unsigned char N_ROLLOFF_BANDS = FEATURE_MAX_BINS / ROLLOFF_BAND_BINS;
+
+  uint64_t sumM = 0, sumKM = 0, sumK2M = 0, sumE = 0;
+  uint64_t bandE[N_BANDS] = {0, 0, 0};
+  uint64_t rolloffE[N_ROLLOFF_BANDS] = {0};
+  int32_t sumLog = 0;
+  uint32_t rise = 0, sumQ = 0;
+  for (unsigned short k = 1; k < bins; k++) {
+    uint32_t m = cabsf(spectrum[k]);
+    uint64_t e = (uint64_t)m * m;
+    sumM += m;
+    sumKM += (uint64_t)k * m;
+    sumK2M += (uint64_t)k * k * m;
+    sumE += e;
+    bandE[k < lowBin ? BAND_LOW : (k < highBin ? BAND_MID : BAND_HIGH)] += e;
+    rolloffE[k / ROLLOFF_BAND_BINS] += e;
+    sumLog += log2Q8(m);
+
+    uint32_t q = m >> FLUX_SHIFT;
+    q = q < 0xFFFF ? q : 0xFFFF;
+    if (q > spectralFeatures::previous[k]) rise += q - spectralFeatures::previous[k];
+    sumQ += q;
+    spectralFeatures::previous[k] = q;
+  }
+
+  unsigned short n = bins - 1;
+  if (sumM == 0) { // Silence, nothing to describe.
+    f = {0, 0, 0, 0, {0, 0, 0}, 0};
+    spectralFeatures::primed = true;
+    return;
+  }
+  float centroidBin = (float)sumKM / sumM;
+  float variance = (float)sumK2M / sumM - centroidBin * centroidBin;
+  f.centroid = centroidBin * hzPerBin;
+  f.spread = (variance > 0 ? sqrtf(variance) : 0) * hzPerBin;
+  f.flatness = exp2f(sumLog / (256.0f * n)) / ((float)sumM / n);
+  if (f.flatness > 1) f.flatness = 1; // The truncated logarithm may round up a flat spectrum.
+
+  float total = sumE > 0 ? (float)sumE : 1;
+  for (unsigned char b = 0; b < N_BANDS; b++) f.bands[b] = bandE[b] / total;
+
+  uint64_t target = sumE * ROLLOFF_FRACTION, cumulative = 0;
+  unsigned char band = 0;
+  while (band < N_ROLLOFF_BANDS - 1 and cumulative + rolloffE[band] < target) cumulative += rolloffE[band++];
+  float inside = rolloffE[band] > 0 ? (float)(target - cumulative) / rolloffE[band] : 0;
+  f.rolloff = (band + inside) * ROLLOFF_BAND_BINS * hzPerBin;
+
+  f.flux = spectralFeatures::primed and sumQ > 0 ? (float)rise / sumQ : 0;
+  spectralFeatures::primed = true;
+}
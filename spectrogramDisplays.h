@@ -12,6 +12,8 @@
 
 #include "board.h"
 #include "display.h"
+#include "waterfall.h"
+#include "cancelToken.h"
 
 // Namespaces
 #include "soundAnalysisToolsNamespaces.h"
@@ -26,7 +28,34 @@ const unsigned short colors[N_COLORS] = {SSD1306_BLACK, SSD1306_WHITE}; /**< Col
 unsigned short graphW; ///< Width of the graph
 unsigned short wOffset; ///< Offset for width
 int log2Sample = log(SAMPLES) / log(2); /**< Logarithm base 2 of the number of samples */
-float _Complex data[SAMPLES]; /**< Data array for the spectrogram */
+const int SPECTROGRAM_THRESHOLD = 160; /**< Amplitude of a lit pixel */
+const unsigned short SPECTROGRAM_SECOND_SAMPLES = 1000u * MAX_FREQ; /**< Samples in one second of the 1 s spectrogram */
+
+/**
+ * @brief State of the 1 second spectrogram.
+ */
+struct SecondSpectrogramState {
+  unsigned long next; /**< Number of the first sample of the next column on the sample ring of the bus */
+  unsigned short x; /**< Next column of the graph */
+  short samples[SAMPLES]; /**< Samples of a column, read from the sample ring */
+  float _Complex data[SAMPLES]; /**< Samples of a column, replaced by its spectrum */
+};
+
+/**
+ * @brief State of the running spectrogram.
+ */
+struct RunningSpectrogramState {
+  Waterfall waterfall; /**< Previous columns of the running spectrogram, bit-packed */
+  float _Complex data[SAMPLES]; /**< Samples of a column, replaced by its spectrum */
+};
+
+/**
+ * @brief State of the sweeping spectrogram.
+ */
+struct SweepingSpectrogramState {
+  unsigned short xPos; /**< X position of the sweeping spectrogram */
+  float _Complex data[SAMPLES]; /**< Samples of a column, replaced by its spectrum */
+};
 
 /**
  * @brief Prints a vertical line on the display.
@@ -43,37 +72,68 @@ float _Complex data[SAMPLES]; /**< Data array for the spectrogram */
  */
 void printVLine(float _Complex *data, int nbFreqD, int x, unsigned short nColors, const unsigned short *colors);
 
+/**
+ * @brief Initializes the spectrogram.
+ *
+ * @details This function clears the display and prints the axes. The graph starts with the last capture.
+ *
+ * @param state The mode state.
+ */
+void initSpectrogram(SecondSpectrogramState &state);
+
 /**
  * @brief Displays the spectrogram.
  *
- * @details This function displays the spectrogram on the display. If the initial parameter is set to true, it clears the display
- * before displaying the spectrogram. The spectrogram is generated based on the provided parameters and data arrays.
+ * @details This function displays the spectrogram on the display. The columns are read hop by hop from the sample
+ * ring of the bus (see busSamples()), one STFT column per hop of SPECTROGRAM_SECOND_SAMPLES / graphW samples, and
+ * drawn from left to right over the previous second, so a pass of the graph spans one second of captured audio. Each
+ * call draws the columns of the last capture, with no capture of its own. The gaps between the captures of the bus
+ * are not recorded. A click stops the columns (see cancelToken.h).
+ *
+ * @param state The mode state.
+ * @param frame The last capture.
+ */
+void displaySpectrogram(SecondSpectrogramState &state, const BusFrame &frame);
+
+/**
+ * @brief Initializes the running spectrogram.
+ *
+ * @details This function clears the display and the waterfall and prints the vertical axis.
  *
- * @param initial If true, clear the display before displaying the spectrogram.
+ * @param state The mode state.
  */
-void displaySpectrogram(bool initial);
+void initRunningSpectrogram(RunningSpectrogramState &state);
 
 /**
  * @brief Displays the running spectrogram.
  *
- * @details This function displays the running spectrogram on the display. If the initial parameter is set to true, it clears the
- * display before displaying the running spectrogram. The running spectrogram is generated based on the provided
- * parameters and data arrays.
+ * @details This function displays the running spectrogram on the display. Each block of SAMPLES samples of the last
+ * capture becomes a column of the waterfall.
+ *
+ * @param state The mode state.
+ * @param frame The last capture.
+ */
+void displayRunningSpectrogram(RunningSpectrogramState &state, const BusFrame &frame);
+
+/**
+ * @brief Initializes the sweeping spectrogram.
+ *
+ * @details This function clears the display and prints the vertical axis.
  *
- * @param initial If true, clear the display before displaying the running spectrogram.
+ * @param state The mode state.
  */
-void displayRunningSpectrogram(bool initial);
+void initSweepingSpectrogram(SweepingSpectrogramState &state);
 
 /**
  * @brief Displays the sweeping spectrogram.
  *
- * @details This function displays the sweeping spectrogram on the display. If the initial parameter is set to true, it clears the
- * display before displaying the sweeping spectrogram. The sweeping spectrogram is generated based on the provided
- * parameters and data arrays.
+ * @details This function displays the sweeping spectrogram on the display. Each block of SAMPLES samples of the last
+ * capture is written as a column at the cursor.
  *
- * @param initial If true, clear the display before displaying the sweeping spectrogram.
+ * @param state The mode state.
+ * @param frame The last capture.
  */
-void displaySweepingSpectrogram(bool initial);
+void displaySweepingSpectrogram(SweepingSpectrogramState &state, const BusFrame &frame);
 
 // Code
 void printVLine(float _Complex *data, int nbFreqD, int x, unsigned short nColors, const unsigned short *colors) {
@@ -87,124 +147,99 @@ void printVLine(float _Complex *data, int nbFreqD, int x, unsigned short nColors
   }
 }
 
-void displaySpectrogram(bool initial) {
-  static long chronoTo1Sec; ///< Variable to track time for 1 second display
-  static float nTimes = 70.0f; /**< Number of times to display the spectrogram */
+void initSpectrogram(SecondSpectrogramState &state) {
+  display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);  
+  display.setTextSize(1);
+  display.clearDisplay();
+  hOffset = FONT_HEIGHT - 1;
+  wOffset = FONT_WIDTH;
+  graphH = DISPLAY_HEIGHT - hOffset;
+  graphW = DISPLAY_WIDTH - wOffset;
 
-  if (initial) {    
-    title[0] = "1 Second";
-    title[1] = "Spectrogram";    
-    display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);  
-    display.setTextSize(1);
-    display.clearDisplay();
-    hOffset = FONT_HEIGHT - 1;
-    wOffset = FONT_WIDTH;
-    graphH = DISPLAY_HEIGHT - hOffset;
-    graphW = DISPLAY_WIDTH - wOffset;
+  // print vertical axis
+  short k = 1;
+  short vDist = (k * 16) + hOffset + 4;
+  do {      
+    display.setCursor(0, DISPLAY_HEIGHT - vDist);
+    display.println(String(k * 2)); // 128 samples -> *2
+    k++;
+    vDist = (k * 16) + hOffset + 4;
+  } while(vDist < DISPLAY_HEIGHT);
 
-    // print vertical axis
-    short k = 1;
-    short vDist = (k * 16) + hOffset + 4;
-    do {      
-      display.setCursor(0, DISPLAY_HEIGHT - vDist);
-      display.println(String(k * 2)); // 128 samples -> *2
-      k++;
-      vDist = (k * 16) + hOffset + 4;
-    } while(vDist < DISPLAY_HEIGHT);
-
-    // print horizontal axis
-    unsigned char marks = 5;
-    String nums[marks] = {"0", "0.25", "0.5", "0.75", "1"};
-    for (unsigned char k = 0; k < marks; k++) {
-      short mult = (DISPLAY_WIDTH - 1 - ((FONT_WIDTH * 2) + (nums[marks - 1].length() / 2))) / (marks - 1); // *2 by left and right margin, "1" by division margin error.
-      short x = (6 + (k * mult)) - ((FONT_WIDTH * nums[k].length())/2);
-      display.setCursor(x, graphH + 1);
-      display.println(nums[k]);
-    }
-    display.setCursor(graphW, graphH + 1);
-    display.println("s"); 
+  // print horizontal axis
+  unsigned char marks = 5;
+  String nums[marks] = {"0", "0.25", "0.5", "0.75", "1"};
+  for (unsigned char k = 0; k < marks; k++) {
+    short mult = (DISPLAY_WIDTH - 1 - ((FONT_WIDTH * 2) + (nums[marks - 1].length() / 2))) / (marks - 1); // *2 by left and right margin, "1" by division margin error.
+    short x = (6 + (k * mult)) - ((FONT_WIDTH * nums[k].length())/2);
+    display.setCursor(x, graphH + 1);
+    display.println(nums[k]);
   }
+  display.setCursor(graphW, graphH + 1);
+  display.println("s"); 
+
+  unsigned long written = spectrumBus::ringSamples;
+  state.next = written >= BUS_SAMPLES ? written - BUS_SAMPLES : 0;
+  state.x = 0;
+}
 
-  // Clear 2D graphic
-  display.fillRect(wOffset, 0, DISPLAY_WIDTH, graphH, SSD1306_BLACK);
-  float scaleW = (float)graphW / nTimes;
-  bool printedVLines[graphW] = { false };
-  for (int j = 0; j < (int)nTimes; j++) {
-    if (digitalRead(BUTTON_P_PIN) == LOW) return;   // Exit in the middle of calcs.    
-    getData(data, SAMPLES, log2Sample); 
-    if (j == 0) printVLine(data, graphH, wOffset, N_COLORS, colors);
-    else {
-      short x = (j * scaleW);
-      while (x > 0 && !printedVLines[x]) {  // Print all Graphic if nTimes < spectrogramGraphW.
-        printVLine(data, graphH, x + wOffset, N_COLORS, colors);
-        printedVLines[x] = true;
-        x--;
-      }    
-    }
-  } 
+void displaySpectrogram(SecondSpectrogramState &state, const BusFrame &frame) {
+  float _Complex *data = state.data;
+
+  // One STFT column per hop of the captured samples.
+  unsigned short hop = SPECTROGRAM_SECOND_SAMPLES / graphW;
+  unsigned long written = spectrumBus::ringSamples;
+  if (written - state.next > BUS_RING_SAMPLES) state.next = written - BUS_SAMPLES; // Missed captures, go on with the last.
+  while (busSamples(state.next, SAMPLES, state.samples) and !analysisCancel.cancelled()) {
+    for (unsigned short i = 0; i < SAMPLES; i++) data[i] = state.samples[i];
+    transform(data, log2Sample);
+    display.fillRect(state.x + wOffset, 0, 1, graphH, SSD1306_BLACK);
+    printVLine(data, graphH, state.x + wOffset, N_COLORS, colors);
+    state.next += hop;
+    state.x = (state.x + 1) % graphW;
+  }
   
   // display vertical legend
   display.fillRect((FONT_WIDTH * 2) - 2, 0, (FONT_WIDTH * 3) + 2, FONT_HEIGHT + 1, SSD1306_BLACK);
   display.setCursor(FONT_WIDTH * 2, 0);
   display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
   display.println("kHz");
-  
-  // Autoadjust horizontal quality to show exactly 1 second.
-  if (abs((long)(millis() - chronoTo1Sec - 1000ul)) > 1 ) {
-    float modPercent = (float)1000ul / (float)(millis() - chronoTo1Sec);
-    nTimes = nTimes * modPercent;;
-  }
-  chronoTo1Sec = millis();
 }
 
-void displayRunningSpectrogram(bool initial) {
-  static unsigned short prevLines[DISPLAY_WIDTH][DISPLAY_HEIGHT]; /**< Previous lines in the running spectrogram */
-
-  if (initial) {
-    title[0] = "Running";
-    title[1] = "Spectrogram";    
-    display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);  
-    display.setTextSize(1);
-    display.clearDisplay();
-    wOffset = FONT_WIDTH;
+void initRunningSpectrogram(RunningSpectrogramState &state) {
+  display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);  
+  display.setTextSize(1);
+  display.clearDisplay();
+  wOffset = FONT_WIDTH;
 
-    // clear prevLines
-    for (short i = 0; i < DISPLAY_WIDTH; i++) {
-      for (short j = 0; j < DISPLAY_HEIGHT; j++) {
-        prevLines[i][j] = 0;
-      }
-    }
-    
-    // print vertical axis    
-    short k = 1;
-    short vDist = (k * 16) + 4;
-    do {      
-      display.setCursor(0, (DISPLAY_HEIGHT + 1) - vDist);
-      display.println(String(k * 2)); // 128 samples -> *2
-      k++;
-      vDist = (k * 16) + 4;
-    } while(vDist < DISPLAY_HEIGHT);
-  }  
+  state.waterfall.clear();
+  
+  // print vertical axis    
+  short k = 1;
+  short vDist = (k * 16) + 4;
+  do {      
+    display.setCursor(0, (DISPLAY_HEIGHT + 1) - vDist);
+    display.println(String(k * 2)); // 128 samples -> *2
+    k++;
+    vDist = (k * 16) + 4;
+  } while(vDist < DISPLAY_HEIGHT);
+}
 
-  getData(data, SAMPLES, log2Sample);
+void displayRunningSpectrogram(RunningSpectrogramState &state, const BusFrame &frame) {
+  Waterfall &waterfall = state.waterfall;
+  float _Complex *data = state.data;
 
-  for (unsigned short i = 1; i <= DISPLAY_HEIGHT; i++) {
-    int amplitude = abs((int)creal(data[i+1]));
-    unsigned short iColor = map(amplitude, 0, 160, 0, N_COLORS - 1);
-    if (iColor < 0) iColor = 0;
-    if (iColor > N_COLORS - 1) iColor = N_COLORS - 1;
-    short y = DISPLAY_HEIGHT - i;
-    display.writePixel(wOffset, y, colors[iColor]);
-    prevLines[wOffset][y] = colors[iColor];
+  unsigned char column[WATERFALL_PAGES];
+  for (unsigned short from = 0; from < BUS_SAMPLES; from += SAMPLES) {
+    getData(frame, from, data, SAMPLES, log2Sample);
+    quantizeColumn(data, 2, SPECTROGRAM_THRESHOLD, column);
+    waterfall.push(column);
   }
+  if (!governorRender()) return; // Columns are kept, only the frame is skipped.
 
-  // Print and move previous graphics.
-  for (short i = DISPLAY_WIDTH - 2; i > wOffset; i--) {
-    for (short j = 0; j < DISPLAY_HEIGHT; j++) {
-      prevLines[i][j] = prevLines[i - 1][j];      
-      display.writePixel(i, j, prevLines[i][j]);
-    }
-  }
+  // Print previous graphics, newest on the left.
+  waterfall.blit(display.getBuffer(), wOffset, DISPLAY_WIDTH - 2);
+  display.markDirty(wOffset, 0, DISPLAY_WIDTH - 1 - wOffset, DISPLAY_HEIGHT);
   
   // display vertical legend
   display.fillRect(0, 0, (FONT_WIDTH * 3) + 2, FONT_HEIGHT, SSD1306_BLACK);
@@ -213,48 +248,41 @@ void displayRunningSpectrogram(bool initial) {
   display.println("kHz");
 }
 
-void displaySweepingSpectrogram(bool initial) {
-  static unsigned short xPos = 0; /**< X position of the sweeping spectrogram */
-
-  if (initial) {
-    title[0] = "Sweeping";
-    title[1] = "Spectrogram";  
-    display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);  
-    display.setTextSize(1);
-    display.clearDisplay();
-    wOffset = FONT_WIDTH;
-    graphW = display.width() - wOffset;
-    xPos = 0;
-    
-    // print vertical axis    
-    short k = 1;
-    short vDist = (k * 16) + 4;
-    do {      
-      display.setCursor(0, (DISPLAY_HEIGHT + 1) - vDist);
-      display.println(String(k * 2)); // 128 samples -> *2
-      k++;
-      vDist = (k * 16) + 4;
-    } while(vDist < DISPLAY_HEIGHT);
-  }
-
-  getData(data, SAMPLES, log2Sample);
+void initSweepingSpectrogram(SweepingSpectrogramState &state) {
+  display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);  
+  display.setTextSize(1);
+  display.clearDisplay();
+  wOffset = FONT_WIDTH;
+  graphW = display.width() - wOffset;
+  state.xPos = 0;
   
-  // Sweeping effect
-  display.drawFastVLine(xPos + wOffset + 1, 0, DISPLAY_HEIGHT, SSD1306_WHITE);
-  display.drawFastVLine(xPos + wOffset + 2, 0, DISPLAY_HEIGHT, SSD1306_BLACK);
-  display.drawFastVLine(xPos + wOffset + 3, 0, DISPLAY_HEIGHT, SSD1306_BLACK);
-  display.drawFastVLine(xPos + wOffset + 4, 0, DISPLAY_HEIGHT, SSD1306_BLACK);
+  // print vertical axis    
+  short k = 1;
+  short vDist = (k * 16) + 4;
+  do {      
+    display.setCursor(0, (DISPLAY_HEIGHT + 1) - vDist);
+    display.println(String(k * 2)); // 128 samples -> *2
+    k++;
+    vDist = (k * 16) + 4;
+  } while(vDist < DISPLAY_HEIGHT);
+}
 
-  // Draw data
-  for (unsigned short i = 1; i <= DISPLAY_HEIGHT; i++) {
-    int amplitude = abs((int)creal(data[i + 1]));
-    unsigned short iColor = map(amplitude, 0, 160, 0, N_COLORS - 1);
-    if (iColor < 0) iColor = 0;
-    if (iColor > N_COLORS - 1) iColor = N_COLORS - 1;
-    short y = DISPLAY_HEIGHT - i;
-    display.writePixel(xPos + wOffset, y, colors[iColor]);
+void displaySweepingSpectrogram(SweepingSpectrogramState &state, const BusFrame &frame) {
+  unsigned short &xPos = state.xPos;
+  float _Complex *data = state.data;
+
+  // Sweeping effect and data, written as whole page columns.
+  static const unsigned char cursor[WATERFALL_PAGES] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  static const unsigned char blank[WATERFALL_PAGES] = {0};
+  unsigned char column[WATERFALL_PAGES];
+  for (unsigned short from = 0; from < BUS_SAMPLES; from += SAMPLES) {
+    getData(frame, from, data, SAMPLES, log2Sample);
+    quantizeColumn(data, 2, SPECTROGRAM_THRESHOLD, column);
+    display.writeColumn(xPos + wOffset, column);
+    display.writeColumn(xPos + wOffset + 1, cursor);
+    for (short j = 2; j <= 4; j++) display.writeColumn(xPos + wOffset + j, blank);
+    xPos = (xPos + 1) % graphW;
   }
-  xPos = (xPos + 1) % graphW;
 
   // display vertical legend
   display.fillRect(0, 0, (FONT_WIDTH * 3) + 2, FONT_HEIGHT + 1, SSD1306_BLACK);
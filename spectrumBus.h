@@ -0,0 +1,204 @@
+/**
+ * @file spectrumBus.h
+ * @brief Shared capture and spectrum of the listening and tool modes
+ *
+ * This file contains the only sound capture of the device. Each capture records a block
+ * of samples, computes its spectrum, finds its peak, extracts its spectral features (see
+ * spectralFeatures.h) and estimates its pitch (see pitchDetector.h) once, and publishes the
+ * result in a BusFrame. The alert matching and the active tool mode both read the same
+ * frame, so the alerts keep working while a tool mode is shown at no extra capture cost.
+ *
+ * The power spectra of the captures are also averaged over BUS_PSD_AVERAGES captures (see
+ * psdAverage.h), for the alerts that match the peak of the averaged spectrum.
+ *
+ * The frame keeps the raw samples next to the spectrum: the time-domain modes and the
+ * spectrograms (shorter FFTs for time resolution) work on the samples, the spectrum modes
+ * on the spectrum. The samples of the last captures are also kept in a sample ring, counted
+ * from the first capture, so a mode can read windows that straddle two captures (see
+ * busSamples()).
+ *
+ * A click cancels the capture (see cancelToken.h): the frame is marked cancelled and keeps
+ * the samples and the spectrum of the previous capture. The samples are recorded in a
+ * scratch buffer and only copied to the frame when the capture completes, so a cancelled
+ * capture leaves no partial data in it.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include <complex.h>
+#include "board.h"
+#include "fft.h"
+#include "latencyStats.h"
+#include "frameGovernor.h"
+#include "cycleTelemetry.h"
+#include "cancelToken.h"
+#include "spectralFeatures.h"
+#include "pitchDetector.h"
+#include "psdAverage.h"
+
+// ---------- Constants --------------
+/**
+ * @brief Samples of a capture.
+ */
+const unsigned short BUS_SAMPLES = 1024;
+
+/**
+ * @brief Logarithm base 2 of BUS_SAMPLES.
+ */
+const unsigned char BUS_LOG2_SAMPLES = 10;
+
+/**
+ * @brief Sampling frequency (kHz).
+ */
+const unsigned char BUS_MAX_FREQ = 16;
+
+/**
+ * @brief Hz per bin of the capture spectrum, measured on the device.
+ */
+const float BUS_HZ_PER_BIN = 15.2256;
+
+/**
+ * @brief Bins of the averaged power spectrum, up to the Nyquist frequency.
+ */
+const unsigned short BUS_PSD_BINS = BUS_SAMPLES / 2;
+
+/**
+ * @brief Captures of the averaged power spectrum of the alerts (about 1 s).
+ */
+const unsigned short BUS_PSD_AVERAGES = 8;
+
+/**
+ * @brief Samples of the sample ring, the last two captures.
+ */
+const unsigned short BUS_RING_SAMPLES = 2 * BUS_SAMPLES;
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Result of a capture.
+ */
+struct BusFrame {
+  short samples[BUS_SAMPLES]; /**< Raw ADC samples. */
+  float _Complex spectrum[BUS_SAMPLES]; /**< Spectrum of the samples (Hamming window). The peak search reads the real part. */
+  float peakA; /**< Amplitude of the peak bin. */
+  int peakI; /**< Peak bin, 0 if none. */
+  float meanA; /**< Mean amplitude of the bins, the noise floor. */
+  SpectralFeatures features; /**< Shape of the spectrum. */
+  PitchEstimate pitch; /**< Fundamental frequency. */
+  float averageA; /**< Amplitude of the peak bin of the averaged power spectrum, the square root of its mean power. */
+  int averageI; /**< Peak bin of the averaged power spectrum, 0 if none. */
+  unsigned long sequence; /**< Number of the capture, from 1. */
+  bool cancelled; /**< True if the last capture was cancelled, the other fields are of the previous one. */
+};
+
+/**
+ * @namespace spectrumBus
+ * @brief Namespace for the last published capture.
+ */
+namespace spectrumBus {
+  BusFrame frame; /**< Last capture, read-only outside this file. */
+  short pending[BUS_SAMPLES]; /**< Samples of the capture in progress. */
+  short ring[BUS_RING_SAMPLES]; /**< Samples of the last captures, sample n in slot n % BUS_RING_SAMPLES. */
+  unsigned long ringSamples = 0; /**< Samples written to the ring since the first capture. */
+  PsdAverage<BUS_PSD_BINS> average; /**< Power spectrum of the last BUS_PSD_AVERAGES captures, read-only outside this file. */
+}
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Captures a block, computes its spectrum, peak, features and pitch, adds it to the
+ * averaged power spectrum and publishes it.
+ *
+ * Stops at the next sample if analysisCancel is cancelled, see BusFrame::cancelled.
+ *
+ * @return The published frame, valid until the next capture.
+ */
+const BusFrame &captureSpectrum();
+
+/**
+ * @brief Reads samples of the last captures from the sample ring.
+ * @param from Number of the first sample, counted from the first capture.
+ * @param n Number of samples, <= BUS_RING_SAMPLES.
+ * @param out Output, n samples.
+ * @return False if the samples are not captured yet or already overwritten.
+ */
+bool busSamples(unsigned long from, unsigned short n, short *out);
+
+// ---------- Code --------------
+const BusFrame &captureSpectrum() {
+  static const unsigned long sampling_period_us = round(1000ul * (1.0 / BUS_MAX_FREQ)); // 1/Hz = T(s) -> 1/kHz = T(ms)
+  BusFrame &frame = spectrumBus::frame;
+  short *pending = spectrumBus::pending;
+
+  latencyFrameStart();
+  CYCLE_BEGIN(CYC_ACQUIRE);
+  frame.cancelled = false;
+  for (unsigned short i = 0; i < BUS_SAMPLES; i++) {
+    if (analysisCancel.cancelled()) {
+      frame.cancelled = true;
+      break;
+    }
+    unsigned long chrono = micros();
+    pending[i] = analogRead(MIC_PIN);
+    while (micros() - chrono < sampling_period_us); // only if analogRead time < sampling_period_us
+  }
+  for (unsigned short i = 0; i < BUS_SAMPLES and !frame.cancelled; i++) { // Only a whole capture replaces the frame.
+    frame.samples[i] = pending[i];
+    frame.spectrum[i] = pending[i];
+    spectrumBus::ring[(spectrumBus::ringSamples + i) % BUS_RING_SAMPLES] = pending[i];
+  }
+  if (!frame.cancelled) spectrumBus::ringSamples += BUS_SAMPLES;
+  CYCLE_END(CYC_ACQUIRE);
+  if (frame.cancelled) return frame; // The next mode captures its own.
+  latencyMark(LAT_CAPTURE);
+  CYCLE_BEGIN(CYC_WINDOW);
+  applyWindow(frame.spectrum, BUS_LOG2_SAMPLES, HAMMING, FFT_FORWARD);
+  CYCLE_END(CYC_WINDOW);
+  latencyMark(LAT_WINDOW);
+  CYCLE_BEGIN(CYC_FFT);
+  performFFT(frame.spectrum, BUS_LOG2_SAMPLES, FFT_FORWARD);
+  CYCLE_END(CYC_FFT);
+  latencyMark(LAT_FFT);
+
+  CYCLE_BEGIN(CYC_PEAK);
+  frame.peakA = 0;
+  frame.peakI = 0;
+  float sumA = 0;
+  for (unsigned short i = 1; i < BUS_SAMPLES; i++) {
+    float a = creal(frame.spectrum[i]);
+    sumA += fabs(a);
+    if (a > frame.peakA) {
+      frame.peakA = a;
+      frame.peakI = i;
+    }
+  }
+  frame.meanA = sumA / (BUS_SAMPLES - 1);
+  frame.sequence++;
+  CYCLE_END(CYC_PEAK);
+  CYCLE_BEGIN(CYC_FEATURES);
+  extractFeatures(frame.spectrum, BUS_SAMPLES / 2, BUS_HZ_PER_BIN, frame.features);
+  CYCLE_END(CYC_FEATURES);
+  CYCLE_BEGIN(CYC_PITCH);
+  estimatePitch(frame.spectrum, BUS_LOG2_SAMPLES, BUS_HZ_PER_BIN * BUS_SAMPLES, frame.pitch);
+  CYCLE_END(CYC_PITCH);
+  CYCLE_BEGIN(CYC_PSD);
+  PsdAverage<BUS_PSD_BINS> &average = spectrumBus::average;
+  if (average.length == 0) average.reset(BUS_PSD_AVERAGES);
+  average.add(frame.spectrum);
+  float power;
+  frame.averageI = average.peak(1, power);
+  frame.averageA = sqrtf(power);
+  CYCLE_END(CYC_PSD);
+  latencyMark(LAT_PEAK);
+  governorAnalysis();
+  return frame;
+}
+
+bool busSamples(unsigned long from, unsigned short n, short *out) {
+  unsigned long written = spectrumBus::ringSamples;
+  if (from + n > written or written - from > BUS_RING_SAMPLES) return false;
+  for (unsigned short i = 0; i < n; i++) out[i] = spectrumBus::ring[(from + i) % BUS_RING_SAMPLES];
+  return true;
+}
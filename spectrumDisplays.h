@@ -3,9 +3,9 @@
  * @brief This file contains the code for displaying sound spectrum.
  *
  * This file includes the necessary functions and variables to display
- * sound spectrum on a display. It provides two different display modes:
- * "Vertical Lines" and "Continuous Line". The spectrum data is
- * acquired using Fast Fourier Transform (FFT) algorithms and is
+ * sound spectrum on a display. It provides four different display modes:
+ * "Vertical Lines", "Continuous Line", "Log Frequency" and "Mel". The spectrum data
+ * comes from the spectrum bus (see spectrumBus.h) and is
  * processed to generate the graphical representation on the display.
  * The display can show either vertical lines or a continuous line graph
  * representing the frequency and amplitude of the sound spectrum.
@@ -18,6 +18,9 @@
 
 #include "board.h"
 #include "display.h"
+#include "textOverlay.h"
+#include "spectrumScale.h"
+#include "peakHold.h"
 
 // Namespaces
 #include "soundAnalysisToolsNamespaces.h"
@@ -26,32 +29,104 @@ using namespace commonDisplays;
 using namespace commonSpectrum;
 using namespace minMax;
 
+// Constants
+const unsigned char SPECTRUM_PEAK_HOLD = 8; /**< Frames a spectrum peak is held. */
+const unsigned char SPECTRUM_PEAK_DECAY = 1; /**< Pixels a spectrum peak falls per frame. */
+const unsigned short SPECTRUM_BINS = BUS_SAMPLES / 2 + 1; /**< Bins of the bus spectrum up to the Nyquist frequency. */
+const unsigned short SPECTRUM_FROM_BIN = BUS_SAMPLES / 256; /**< First bin of the spectrum modes (62 Hz). */
+const float SPECTRUM_GAIN = 256.0f / BUS_SAMPLES; /**< Bus amplitudes to the units of a 256-sample FFT, used by the readouts. */
+const unsigned short BARS_FROM_BIN = BUS_SAMPLES / 64; /**< First bin of the spectrum bars (250 Hz). */
+const float BARS_GAIN = 128.0f / BUS_SAMPLES; /**< Bus amplitudes to the units of a 128-sample FFT. */
+
+// Struct Definition
+/**
+ * @brief State of the spectrum modes.
+ */
+struct SpectrumState {
+  float _Complex data[SPECTRUM_BINS]; /**< Spectrum of the frame. */
+  PeakHold peaks; /**< Peak markers. */
+  SpectrumMap map; /**< Column to bin table. */
+  SpectrumAccumulator<SPECTRUM_BINS> accumulator; /**< Spectra between two frames. */
+  unsigned short level[DISPLAY_WIDTH]; /**< Level of each column in the last frame, in pixels. */
+  unsigned char mode; /**< 0 vertical lines, 1 continuous line, 2 log frequency, 3 mel. */
+};
+
+/**
+ * @brief State of the spectrum bars.
+ */
+struct SpectrumBarsState {
+  float _Complex data[SPECTRUM_BINS]; /**< Spectrum of the frame. */
+  SpectrumMap map; /**< Bar to bin table. */
+  SpectrumAccumulator<SPECTRUM_BINS> accumulator; /**< Spectra between two frames. */
+};
+
 // Headers
 /**
  * @brief Prints the spectrum display with continuous lines.
  *
  * @details This function prints the spectrum display with continuous lines using the data array.
- * It calculates the amplitude of each frequency bin and draws a line from the previous bin's amplitude
- * to the current bin's amplitude. It also calculates and displays the maximum amplitude and frequency.
+ * It calculates the amplitude of each column and draws a line from the previous column's amplitude
+ * to the current column's amplitude. It also calculates and displays the maximum amplitude and frequency.
  *
- * @param SAMPLES The number of samples in the data array.
- * @param data The array containing the spectrum data.
- * @param peak The array storing the peak values.
+ * @param state The spectrum state, with the spectrum in data.
  */
-void printSpectrumContinuousLineGraphic(unsigned short SAMPLES, float _Complex *data, unsigned char *peak);
+void printSpectrumContinuousLineGraphic(SpectrumState &state);
 
 /**
  * @brief Prints the spectrum display with vertical lines.
  *
  * @details This function prints the spectrum display with vertical lines using the data array.
- * It calculates the amplitude of each frequency bin and draws a vertical line representing the amplitude.
+ * It calculates the amplitude of each column and draws a vertical line representing the amplitude.
  * It also calculates and displays the maximum amplitude and frequency.
  *
+ * @param state The spectrum state, with the spectrum in data.
+ */
+void printSpectrumVLinesGraphic(SpectrumState &state);
+
+/**
+ * @brief Prints the peak frequency and amplitude of the spectrum.
+ *
+ * @details The readout is kept for one second unless a higher peak comes.
+ *
  * @param SAMPLES The number of samples in the data array.
- * @param data The array containing the spectrum data.
- * @param peak The array storing the peak values.
+ * @param bin The bin of the maximum amplitude.
+ */
+void printSpectrumInfo(unsigned short SAMPLES, unsigned short bin);
+
+/**
+ * @brief Initializes a spectrum mode.
+ *
+ * @details This function builds the column table of the mode, clears the peaks and the
+ * accumulator and draws the frequency labels.
+ *
+ * @param state The mode state.
+ * @param mode The display mode (0 for vertical lines, 1 for continuous line, 2 for log frequency, 3 for mel).
+ */
+void initSpectrum(SpectrumState &state, unsigned char mode);
+
+/**
+ * @brief Initializes the spectrum with vertical lines.
+ * @param state The mode state.
+ */
+void initSpectrumVLines(SpectrumState &state);
+
+/**
+ * @brief Initializes the spectrum with a continuous line.
+ * @param state The mode state.
  */
-void printSpectrumVLinesGraphic(unsigned short SAMPLES, float _Complex *data, unsigned char *peak);
+void initSpectrumContinuousLine(SpectrumState &state);
+
+/**
+ * @brief Initializes the spectrum in a log frequency scale.
+ * @param state The mode state.
+ */
+void initSpectrumLogFrequency(SpectrumState &state);
+
+/**
+ * @brief Initializes the spectrum in a mel frequency scale.
+ * @param state The mode state.
+ */
+void initSpectrumMel(SpectrumState &state);
 
 /**
  * @brief Displays the spectrum.
@@ -59,240 +134,224 @@ void printSpectrumVLinesGraphic(unsigned short SAMPLES, float _Complex *data, un
  * This function displays the spectrum using the specified display mode.
  * If the mode is set to 0, it displays the spectrum with vertical lines.
  * If the mode is set to 1, it displays the spectrum with continuous lines.
- * The function acquires the sound data, applies a window function, and performs
- * a Fast Fourier Transform (FFT) to obtain the spectrum data. It then calls
- * the appropriate function to print the spectrum display based on the mode.
+ * If the mode is set to 2, it displays the spectrum with vertical lines in a log frequency scale.
+ * If the mode is set to 3, it displays the spectrum with vertical lines in a mel frequency scale.
+ * The spectrum of each capture of the bus is accumulated and, when a frame is due, the
+ * function calls the appropriate function to print the spectrum display based on the mode.
  *
- * @param initial Specifies if it's the initial display.
- * @param mode The display mode (0 for vertical lines, 1 for continuous line).
+ * @param state The mode state.
+ * @param frame The last capture.
  */
-void displaySpectrum(bool initial, unsigned char mode);
+void displaySpectrum(SpectrumState &state, const BusFrame &frame);
+
+/**
+ * @brief Initializes the spectrum bars.
+ *
+ * @details This function builds the bar table and draws the frequency labels.
+ *
+ * @param state The mode state.
+ */
+void initSpectrumBars(SpectrumBarsState &state);
 
 /**
  * @brief Displays the spectrum bars.
  *
- * This function displays the spectrum using bars. It acquires the sound data,
- * applies a window function and performs a Fast Fourier Transform (FFT) to obtain
- * the spectrum data. The spectrum is then visualized using vertical bars, where the
- * height of each bar represents the amplitude of a frequency bin. The number of bars
- * displayed is determined by the number of samples and frequency resolution. The
+ * This function displays the spectrum of the bus captures using bars, where the
+ * height of each bar represents the highest amplitude of its frequency bins. The
  * function also displays the corresponding frequency values on the x-axis.
  *
- * @param initial Specifies if it's the initial display.
+ * @param state The mode state.
+ * @param frame The last capture.
  * */
-void displaySpectrumBars(bool initial);
+void displaySpectrumBars(SpectrumBarsState &state, const BusFrame &frame);
   
 
 // Code
-void printSpectrumContinuousLineGraphic(unsigned short SAMPLES, float _Complex *data, unsigned char *peak) {
-  static long chronoInfo;
-  static int freqMaxInfo;
-  static int ampMaxInfo;
-  const int lowFilterInfo = 800;  
+void printSpectrumContinuousLineGraphic(SpectrumState &state) {
+  const SpectrumMap &map = state.map;
+  unsigned short *level = state.level;
+  const short peakInterval = 3;
 
-  int nFreq = SAMPLES / 2;
-  hOffset = FONT_HEIGHT;
-  graphH = DISPLAY_HEIGHT - hOffset;  
   ampMax = 0;
   unsigned short imax = 0;
-  unsigned char prevPeak = -1;
-  int peakInterval = 3; // recomends odd number;
-  for (unsigned short i = 1; i < min(nFreq, DISPLAY_WIDTH); i++) {    
-    double currentAmplitude = creal(data[i]);
-    double nextAmplitude = creal(data[i + 1]);
-    if (i == DISPLAY_WIDTH - 1) nextAmplitude == currentAmplitude;    
-    if (currentAmplitude > ampMax) {
-      ampMax = (int)currentAmplitude;
-      imax = i;
+  for (unsigned short x = 0; x < map.columns; x++) {
+    unsigned short bin;
+    int amplitude = map.columnPeak(state.data, x, bin);
+    if (amplitude > ampMax) {
+      ampMax = amplitude;
+      imax = bin;
     }
-    short cAmp = map(currentAmplitude, 0.0, (double)MAX_READ_VALUE * 2, 0.0, (double)graphH);
-    short nAmp = map(nextAmplitude, 0.0, (double)MAX_READ_VALUE * 2, 0.0, (double)graphH);
-    cAmp = max(short(0), cAmp);
-    nAmp = max(short(0), nAmp);
-    display.drawLine(i - 1, graphH - cAmp, i, graphH - nAmp, SSD1306_WHITE);
-
-    // Print peak    
-    if (i % peakInterval == (peakInterval / 2)) {
-      int maxPeak = 0;
-      for (int j = 0; j < peakInterval; j++) {
-        int index = i + j - (peakInterval / 2);
-        if (index > 1 && index < min(nFreq, DISPLAY_WIDTH)){
-          maxPeak = max(maxPeak, (int)creal(data[index]));
-        }        
-      }      
-      maxPeak = map(maxPeak, 0, MAX_READ_VALUE * 2, 0, graphH);
-      peak[i] = max((unsigned char)maxPeak, peak[i]);
-      peak[i] = min(peak[i], (unsigned char)graphH);
-      if (prevPeak >= 0 && i > 1) {
-        display.drawLine(i - peakInterval, graphH - prevPeak, i, graphH - peak[i], SSD1306_WHITE);
-      }
-      peak[i] = max(0, peak[i] - 1);
-      prevPeak = peak[i];      
-    }   
-  }  
-    
-  if (millis() - chronoInfo >= 1000ul) ampMaxInfo = 0;
-  if (ampMax > ampMaxInfo & ampMax > lowFilterInfo) {
-    freqMaxInfo = imax * 15.2256 * (1024.0 / SAMPLES);
-    ampMaxInfo = ampMax;
-    chronoInfo = millis();
+    level[x] = map.toPixels(amplitude);
+    if (x > 0) display.drawLine(x - 1, graphH - level[x - 1], x, graphH - level[x], SSD1306_WHITE);
   }
-  
-  display.setTextSize(1);
-  if (ampMaxInfo > 0) {
-    char texte[14];
-    sprintf(texte, "%4d Hz", freqMaxInfo);
-    display.setCursor(DISPLAY_WIDTH - 43, 0);
-    display.println(texte);
-    
-    sprintf(texte, "%5d Am", ampMaxInfo);
-    display.setCursor(DISPLAY_WIDTH - 49, FONT_HEIGHT);
-    display.println(texte);
-  } else {
-    display.setCursor(DISPLAY_WIDTH - 25, 0);
-    display.println("- Hz");
-    display.setCursor(DISPLAY_WIDTH - 25, FONT_HEIGHT);
-    display.println("- Am");
-  } 
+
+  // Print peak
+  PeakHold &peaks = state.peaks;
+  peaks.update(level);
+  for (unsigned short x = peakInterval + 1; x < map.columns; x += peakInterval) {
+    short x0 = x - peakInterval;
+    display.drawLine(x0, graphH - peaks.level[x0], x, graphH - peaks.level[x], SSD1306_WHITE);
+  }
+
+  printSpectrumInfo(BUS_SAMPLES, imax);
 }
 
-void printSpectrumVLinesGraphic(unsigned short SAMPLES, float _Complex *data, unsigned char *peak) {
-  static long chronoInfo;
-  static int freqMaxInfo;
-  static int ampMaxInfo;
-  const short lowFilterInfo = 800;  
+void printSpectrumVLinesGraphic(SpectrumState &state) {
+  const SpectrumMap &map = state.map;
+  unsigned short *level = state.level;
 
-  int nFreq = SAMPLES / 2;
-  hOffset = FONT_HEIGHT;
-  graphH = DISPLAY_HEIGHT - hOffset; 
   ampMax = 0;
   unsigned short imax = 0;
-  for (unsigned short i = 1; i < min(nFreq, (int)DISPLAY_WIDTH); i++) {
-    // Extract amplitude and max. 
-    int amplitude = max(0, (int)creal(data[i]));
+  for (unsigned short x = 0; x < map.columns; x++) {
+    // Extract amplitude and max.
+    unsigned short bin;
+    int amplitude = map.columnPeak(state.data, x, bin);
     if (amplitude > ampMax) {
       ampMax = amplitude;
-      imax = i;
+      imax = bin;
     }
 
     // Print vertical line
-    short reducedAmplitude = map(amplitude, 0, MAX_READ_VALUE * 2, 0, graphH);
-    display.drawFastVLine(i - 1, graphH - reducedAmplitude, reducedAmplitude, SSD1306_WHITE);
-    
-    // Print peak
-    if (i % 3 == 1) {
-      int maxPeak = max(0, (int)creal(data[i]));
-      if (i > 1) maxPeak = max(maxPeak, max(0, (int)creal(data[i - 1])));
-      if (i < DISPLAY_WIDTH - 1) maxPeak = max(maxPeak, max(0, (int)creal(data[i + 1])));      
-      maxPeak = map(maxPeak, 0, MAX_READ_VALUE * 2, 0, graphH);
-      peak[i] = max((unsigned char)maxPeak, peak[i]);
-      peak[i] = min(peak[i], (unsigned char)graphH);
-      if (peak[i] > 8) {
-        short y = graphH - peak[i];
-        display.drawLine(i - 1, y, i + 1, y, SSD1306_WHITE);
-        peak[i] -= 1;
-      }
-    }    
-  }  
-  
+    level[x] = map.toPixels(amplitude);
+    display.drawFastVLine(x, graphH - level[x], level[x], SSD1306_WHITE);
+  }
+
+  // Print peak, one mark every 3 columns.
+  PeakHold &peaks = state.peaks;
+  peaks.update(level);
+  for (unsigned short x = 1; x < map.columns; x += 3) {
+    if (peaks.level[x] > 8) display.drawFastHLine(x - 1, graphH - peaks.level[x], 3, SSD1306_WHITE);
+  }
+
+  printSpectrumInfo(BUS_SAMPLES, imax);
+}
+
+void printSpectrumInfo(unsigned short SAMPLES, unsigned short bin) {
+  static long chronoInfo;
+  static int freqMaxInfo;
+  static int ampMaxInfo;
+  const short lowFilterInfo = 800;
+
   // Calc. freq. and info
   if (millis() - chronoInfo >= 1000ul) ampMaxInfo = 0;
   if (ampMax > ampMaxInfo & ampMax > lowFilterInfo) {
-    freqMaxInfo = imax * 15.2256 * (1024.0 / SAMPLES); // 985.0? * 15.2256 * (1024.0 / LISTEN_SAMPLES)
+    freqMaxInfo = bin * 15.2256 * (1024.0 / SAMPLES); // 985.0? * 15.2256 * (1024.0 / LISTEN_SAMPLES)
     ampMaxInfo = ampMax;
     chronoInfo = millis();
   }
-  
+
   // Print info
   display.setTextSize(1);
   if (ampMaxInfo > 0) {
-    char texte[14];
-    sprintf(texte, "%4d Hz", freqMaxInfo);
-    display.setCursor(DISPLAY_WIDTH - 43, 0);
-    display.println(texte);
-    
-    sprintf(texte, "%5d Am", ampMaxInfo);
-    display.setCursor(DISPLAY_WIDTH - 49, FONT_HEIGHT);
-    display.println(texte);
+    TextLine text;
+    drawText(DISPLAY_WIDTH - 43, 0, text.addInt(freqMaxInfo, 4).add(" Hz").c_str());
+    drawText(DISPLAY_WIDTH - 49, FONT_HEIGHT, text.clear().addInt(ampMaxInfo, 5).add(" Am").c_str());
   } else {
-    display.setCursor(DISPLAY_WIDTH - 25, 0);
-    display.println("- Hz");
-    display.setCursor(DISPLAY_WIDTH - 25, FONT_HEIGHT);
-    display.println("- Am");
-  } 
+    drawText(DISPLAY_WIDTH - 25, 0, "- Hz");
+    drawText(DISPLAY_WIDTH - 25, FONT_HEIGHT, "- Am");
+  }
 }
 
-void displaySpectrum(bool initial, unsigned char mode) {
-  static const unsigned short SAMPLES = 256;
-  static const int log2Sample = log(SAMPLES) / log(2); 
-  static float _Complex data[SAMPLES];
-  static unsigned char peak[SAMPLES] = {0};
+void initSpectrum(SpectrumState &state, unsigned char mode) {
+  const short axisY = DISPLAY_HEIGHT - FONT_HEIGHT + 2;
+  SpectrumMap &map = state.map;
 
-  if (mode == 0) {
-    title[0] = "Spectrum";
-    title[1] = "Vertical Lines";
-  }
-  else if (mode == 1) {
-    title[0] = "Spectrum";
-    title[1] = "Continuous Line";
-  }
+  state.mode = mode;
+  hOffset = FONT_HEIGHT;
+  graphH = DISPLAY_HEIGHT - hOffset;
+  state.accumulator.reset(mode == 1 ? ACCUMULATE_AVERAGE : ACCUMULATE_MAX_HOLD);
 
-  getData(data, SAMPLES, log2Sample);
+  // 62 Hz to the Nyquist frequency, linear, octaves of the same width or mel.
+  unsigned short columns = DISPLAY_WIDTH - 1;
+  FrequencyScale scale = mode == 2 ? SCALE_LOG : mode == 3 ? SCALE_MEL : SCALE_LINEAR;
+  map.build(scale, columns, SPECTRUM_FROM_BIN, SPECTRUM_BINS - 1, BUS_HZ_PER_BIN, MAX_READ_VALUE * 2, graphH);
+  state.peaks.reset(columns, SPECTRUM_PEAK_HOLD, SPECTRUM_PEAK_DECAY, 1);
 
-  int nFreq = SAMPLES / 2;
+  // Static labels, drawn once.
   display.clearDisplay();
   display.setTextColor(SSD1306_WHITE);  
   display.setTextSize(1);
-  float freqs[6] = {1, 2, 3, 4, 5, 6};
-  for (unsigned char i = 0; i < 6; i++) {
-    String numTxt = String((int)freqs[i]);
-    short pos = (16 * freqs[i]) - ((FONT_WIDTH * numTxt.length()) / 2);
-    display.setCursor(pos, DISPLAY_HEIGHT - FONT_HEIGHT + 2);    
-    display.println(numTxt);
+  if (mode == 2) {
+    const char *labels[] = {"0.2", "0.5", "1", "2"};
+    const float hz[] = {200, 500, 1000, 2000};
+    for (unsigned char i = 0; i < 4; i++) {
+      drawCenteredText(map.columnOf(hz[i]), axisY, labels[i]);
+    }
+  } else if (mode == 3) {
+    const char *labels[] = {"0.5", "1", "2", "4"};
+    const float hz[] = {500, 1000, 2000, 4000};
+    for (unsigned char i = 0; i < 4; i++) {
+      drawCenteredText(map.columnOf(hz[i]), axisY, labels[i]);
+    }
+  } else {
+    TextLine numTxt;
+    for (unsigned char i = 1; i <= 6; i++) {
+      drawCenteredText(map.columnOf(1000 * i), axisY, numTxt.clear().addInt(i).c_str());
+    }
   }
-  String kHz = "kHz";
-  display.setCursor(DISPLAY_WIDTH - (FONT_WIDTH * kHz.length()), DISPLAY_HEIGHT - FONT_HEIGHT + 2);
-  display.println(kHz);
+  drawText(DISPLAY_WIDTH - (FONT_WIDTH * 3), axisY, "kHz");
+}
+
+void initSpectrumVLines(SpectrumState &state) {
+  initSpectrum(state, 0);
+}
 
-  if (mode == 0) printSpectrumVLinesGraphic(SAMPLES, data, peak);
-  else if (mode == 1) printSpectrumContinuousLineGraphic(SAMPLES, data, peak);
+void initSpectrumContinuousLine(SpectrumState &state) {
+  initSpectrum(state, 1);
 }
 
-void displaySpectrumBars(bool initial) {
-  static const unsigned short SAMPLES = 128;
-  static const int log2Sample = log(SAMPLES) / log(2);
-  static float _Complex data[SAMPLES];
+void initSpectrumLogFrequency(SpectrumState &state) {
+  initSpectrum(state, 2);
+}
 
-  if (initial) {
-    title[0] = "Spectrum Bars";
-    hOffset = FONT_HEIGHT + 1;
-    graphH = DISPLAY_HEIGHT - hOffset;
-  }  
+void initSpectrumMel(SpectrumState &state) {
+  initSpectrum(state, 3);
+}
 
-  getData(data, SAMPLES, log2Sample);
+void displaySpectrum(SpectrumState &state, const BusFrame &frame) {
+  const short axisY = DISPLAY_HEIGHT - FONT_HEIGHT + 2;
 
-  int nFreq = SAMPLES / 2;
+  state.accumulator.add(frame.spectrum);
+  if (!governorRender()) return;
+  state.accumulator.take(state.data, SPECTRUM_GAIN);
+
+  display.fillRect(0, 0, DISPLAY_WIDTH, axisY, SSD1306_BLACK); // Clear the graph, keep the labels.
+  display.setTextColor(SSD1306_WHITE);  
+
+  if (state.mode == 1) printSpectrumContinuousLineGraphic(state);
+  else printSpectrumVLinesGraphic(state);
+}
+
+void initSpectrumBars(SpectrumBarsState &state) {
+  hOffset = FONT_HEIGHT + 1;
+  graphH = DISPLAY_HEIGHT - hOffset;
+  state.map.build(SCALE_LINEAR, 16, BARS_FROM_BIN, SPECTRUM_BINS - 1, BUS_HZ_PER_BIN, MAX_READ_VALUE, graphH); // 31 bins per bar.
+  state.accumulator.reset(ACCUMULATE_MAX_HOLD);
+
+  // Static labels, drawn once.
   display.clearDisplay();
   display.setTextSize(1);
   display.setTextColor(SSD1306_WHITE);
-  const float freqs[4] = {1, 2, 3, 4};
-  for (unsigned char i = 0; i < 4; i++) {
-    String numTxt = String((int)freqs[i] * 2);    
-    short pos = (31 * freqs[i]) - ((FONT_WIDTH * numTxt.length()) / 2);
-    display.setCursor(pos, graphH + 1);
-    display.println(numTxt);
+  TextLine numTxt;
+  for (unsigned char i = 1; i <= 4; i++) {
+    drawCenteredText(31 * i, graphH + 1, numTxt.clear().addInt(i * 2).c_str());
   }
+  drawText(0, graphH + 1, "kHz");
+}
+
+void displaySpectrumBars(SpectrumBarsState &state, const BusFrame &frame) {
+  float _Complex *data = state.data;
+  const SpectrumMap &map = state.map;
+
+  state.accumulator.add(frame.spectrum);
+  if (!governorRender()) return;
+  state.accumulator.take(data, BARS_GAIN);
 
-  display.setCursor(0, graphH + 1);
-  display.println("kHz");  
+  display.fillRect(0, 0, DISPLAY_WIDTH, graphH + 1, SSD1306_BLACK); // Clear the graph, keep the labels.
   
-  for (short i = 0; i < 16; i++) {
-    short amplitude = 0;
-    for (short j = 0; j < 4; j++) {
-      int sample = (int)creal(data[i * 4 + j + 2]);
-      short candidate = map(sample, 0, MAX_READ_VALUE, 0, graphH);
-      if (amplitude < candidate) amplitude = candidate;
-    }
+  for (unsigned short i = 0; i < map.columns; i++) {
+    unsigned short bin;
+    short amplitude = map.toPixels(map.columnPeak(data, i, bin));
     display.fillRect(i * 8, DISPLAY_HEIGHT - hOffset - amplitude, 6, amplitude, SSD1306_WHITE);
   }
-}
\ No newline at end of file
+}
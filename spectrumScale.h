@@ -0,0 +1,138 @@
+/**
+ * @file spectrumScale.h
+ * @brief Frequency and amplitude mapping tables of the spectrum displays
+ *
+ * This file contains the lookup tables that map display columns to FFT bins. A table is
+ * built once when a mode starts, with a linear, logarithmic or mel frequency scale, and a
+ * fixed-point amplitude to pixel scale. Drawing a column then costs a table lookup and a
+ * max-reduction over its bins, instead of a map() per bin and frame.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <math.h>
+#include <complex.h>
+#include "display.h"
+
+/**
+ * @brief Enumeration of the frequency scales.
+ */
+typedef enum {
+  SCALE_LINEAR,   ///< Same width for every bin
+  SCALE_LOG,      ///< Same width for every octave
+  SCALE_MEL       ///< Mel scale, 2595 * log10(1 + f / 700)
+} FrequencyScale;
+
+/**
+ * @brief Column to bin range table with an amplitude scale.
+ */
+struct SpectrumMap {
+  unsigned short firstBin[DISPLAY_WIDTH]; /**< First bin of each column. */
+  unsigned short lastBin[DISPLAY_WIDTH]; /**< Last bin of each column, >= firstBin. */
+  unsigned short columns; /**< Number of columns of the table. */
+  unsigned long ampScale; /**< Pixels per amplitude unit, 16.16 fixed point. */
+  unsigned short maxPixel; /**< Height of the graph in pixels. */
+  FrequencyScale scale; /**< Frequency scale of the table. */
+  float fromBin; /**< Bin of the left edge of the first column. */
+  float toBin; /**< Bin of the right edge of the last column. */
+  float hzPerBin; /**< Hz per bin of the FFT, used by the mel scale. */
+
+  /**
+   * @brief Warps a frequency to the scale.
+   * @param bin Frequency in bins.
+   * @return Position in the scale units.
+   */
+  float warp(float bin) const {
+    switch (scale) {
+      case SCALE_LOG: return log(bin);
+      case SCALE_MEL: return log10(1.0f + bin * hzPerBin / 700.0f);
+      default: return bin;
+    }
+  }
+
+  /**
+   * @brief Inverse of warp().
+   * @param w Position in the scale units.
+   * @return Frequency in bins.
+   */
+  float unwarp(float w) const {
+    switch (scale) {
+      case SCALE_LOG: return exp(w);
+      case SCALE_MEL: return (pow(10.0f, w) - 1.0f) * 700.0f / hzPerBin;
+      default: return w;
+    }
+  }
+
+  /**
+   * @brief Builds the table.
+   *
+   * @param s Frequency scale.
+   * @param cols Number of columns (<= DISPLAY_WIDTH).
+   * @param from Bin of the left edge of the first column (> 0 for SCALE_LOG).
+   * @param to Bin of the right edge of the last column.
+   * @param hz Hz per bin.
+   * @param ampFull Amplitude shown with the full graph height.
+   * @param pixels Height of the graph in pixels.
+   */
+  void build(FrequencyScale s, unsigned short cols, float from, float to, float hz, long ampFull, unsigned short pixels) {
+    const float eps = 0.001f;
+    scale = s;
+    columns = min(cols, (unsigned short)DISPLAY_WIDTH);
+    fromBin = from;
+    toBin = to;
+    hzPerBin = hz;
+    maxPixel = pixels;
+    ampScale = ((unsigned long)pixels << 16) / ampFull;
+
+    float w0 = warp(from);
+    float step = (warp(to) - w0) / columns;
+    for (unsigned short x = 0; x < columns; x++) {
+      float left = unwarp(w0 + x * step);
+      float right = unwarp(w0 + (x + 1) * step);
+      firstBin[x] = (unsigned short)floor(left + eps);
+      lastBin[x] = max(firstBin[x], (unsigned short)(ceil(right - eps) - 1));
+    }
+  }
+
+  /**
+   * @brief Gets the column that shows a frequency.
+   * @param hz Frequency in Hz.
+   * @return Column, may be out of the table.
+   */
+  short columnOf(float hz) const {
+    return (warp(hz / hzPerBin) - warp(fromBin)) * columns / (warp(toBin) - warp(fromBin));
+  }
+
+  /**
+   * @brief Gets the maximum amplitude of the bins of a column.
+   * @param data The spectrum.
+   * @param x The column.
+   * @param bin Output: bin of the maximum.
+   * @return The amplitude, 0 if negative.
+   */
+  int columnPeak(const float _Complex *data, unsigned short x, unsigned short &bin) const {
+    int amplitude = 0;
+    bin = firstBin[x];
+    for (unsigned short b = firstBin[x]; b <= lastBin[x]; b++) {
+      int a = (int)creal(data[b]);
+      if (a > amplitude) {
+        amplitude = a;
+        bin = b;
+      }
+    }
+    return amplitude;
+  }
+
+  /**
+   * @brief Converts an amplitude to pixels.
+   * @param amplitude Amplitude, >= 0.
+   * @return Height in pixels, <= maxPixel.
+   */
+  unsigned short toPixels(int amplitude) const {
+    unsigned long pixels = ((unsigned long)amplitude * ampScale) >> 16;
+    return min(pixels, (unsigned long)maxPixel);
+  }
+};
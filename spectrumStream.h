@@ -0,0 +1,343 @@
+/**
+ * @file spectrumStream.h
+ * @brief Binary spectrum stream over Serial
+ *
+ * This file contains the Spectrum Stream mode: each capture of the spectrum bus is sent
+ * over Serial as a SERIAL_FRAME_SPECTRUM frame (see serialFrame.h), so the live spectra can
+ * be watched on a computer. tools/spectrumStreamDecoder.cpp turns the stream into a
+ * scrolling spectrogram image.
+ *
+ * Each of the STREAM_BINS bins (0 to 8 kHz) is quantized to 8 bits in STREAM_DB_STEP dB
+ * steps. The bins under STREAM_GATE times the mean magnitude (the noise floor) are sent as
+ * 0: the noise changes on every capture and would fill the frames. The frame is coded
+ * against the spectrum the decoder already has:
+ * - Key frame: the quantized values.
+ * - Delta frame: the change of each bin, mod 256. Changes of STREAM_DEADBAND steps or
+ *   less are sent as 0, so the unchanged parts of the spectrum are long runs of zeros.
+ *   The encoder keeps the decoder copy, so the skipped changes never accumulate.
+ * Both are packed with PackBits (run-length). The smaller one is sent, and a key frame
+ * every STREAM_KEY_INTERVAL frames lets a decoder join the stream or recover from a lost
+ * frame.
+ *
+ * Payload of a frame, little endian:
+ *   sequence (4) | kind (1) | bins (2) | Hz per bin x100 (2) | PackBits data
+ *
+ * The codec only needs the standard library, the host decoder uses it with
+ * SPECTRUM_STREAM_FORMAT_ONLY defined.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "serialFrame.h"
+
+// ---------- Constants --------------
+/**
+ * @brief Bins of a streamed spectrum, half of a capture.
+ */
+const uint16_t STREAM_BINS = 512;
+
+/**
+ * @brief dB of a quantization step.
+ */
+const float STREAM_DB_STEP = 0.5f;
+
+/**
+ * @brief Bins under this factor of the mean magnitude are sent as 0 (6 dB).
+ */
+const float STREAM_GATE = 2.0f;
+
+/**
+ * @brief Largest change (steps) a delta frame doesn't send.
+ */
+const unsigned char STREAM_DEADBAND = 2;
+
+/**
+ * @brief Frames between two forced key frames.
+ */
+const unsigned char STREAM_KEY_INTERVAL = 64;
+
+/**
+ * @brief Bytes of the payload header.
+ */
+const unsigned char STREAM_HEADER_BYTES = 9;
+
+/**
+ * @brief Largest PackBits output of a spectrum: one control byte per 128 literals.
+ */
+const uint16_t STREAM_PACKED_MAX = STREAM_BINS + (STREAM_BINS + 127) / 128;
+
+static_assert(STREAM_HEADER_BYTES + STREAM_PACKED_MAX <= SERIAL_FRAME_MAX_PAYLOAD, "Spectrum frame over the frame payload");
+
+/**
+ * @brief Kinds of spectrum frame.
+ */
+typedef enum {
+  STREAM_KEY = 0,   ///< Quantized values
+  STREAM_DELTA = 1, ///< Changes from the previous frame
+} StreamFrameKind;
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Quantizes a magnitude.
+ * @param magnitude Magnitude of a bin.
+ * @return Level in dB / STREAM_DB_STEP, 0 below 1.
+ */
+uint8_t quantizeMagnitude(float magnitude);
+
+/**
+ * @brief Packs bytes with PackBits.
+ *
+ * @details A control byte c is followed by c + 1 literal bytes if c < 128, or by one byte
+ * repeated 257 - c times otherwise.
+ *
+ * @param in The bytes.
+ * @param n Number of bytes.
+ * @param out Output, at least n + (n + 127) / 128 bytes.
+ * @return Bytes written.
+ */
+uint16_t packBits(const uint8_t *in, uint16_t n, uint8_t *out);
+
+/**
+ * @brief Unpacks PackBits data.
+ * @param in The packed data.
+ * @param length Bytes of packed data.
+ * @param out Output.
+ * @param n Number of bytes expected.
+ * @return False if the data doesn't unpack to exactly n bytes.
+ */
+bool unpackBits(const uint8_t *in, uint16_t length, uint8_t *out, uint16_t n);
+
+// ---------- Class Definition --------------
+/**
+ * @class SpectrumStreamEncoder
+ * @brief Codes quantized spectra as key or delta frames.
+ */
+class SpectrumStreamEncoder {
+private:
+  uint8_t reference[STREAM_BINS]; /**< Spectrum held by the decoder. */
+  uint8_t changes[STREAM_BINS]; /**< Delta frame being coded. */
+  uint8_t packed[STREAM_PACKED_MAX]; /**< Packed delta frame. */
+  uint32_t sequence = 0; /**< Number of the next frame. */
+  StreamFrameKind last = STREAM_KEY; /**< Kind of the last frame. */
+
+public:
+  /**
+   * @brief Codes a spectrum.
+   * @param levels Quantized spectrum, STREAM_BINS values.
+   * @param centiHzPerBin Hz per bin x100, for the decoder.
+   * @param payload Output, STREAM_HEADER_BYTES + STREAM_PACKED_MAX bytes.
+   * @return Bytes of the payload.
+   */
+  uint16_t encode(const uint8_t *levels, uint16_t centiHzPerBin, uint8_t *payload) {
+    uint8_t *keyData = payload + STREAM_HEADER_BYTES;
+    uint16_t keyLength = packBits(levels, STREAM_BINS, keyData);
+
+    uint16_t deltaLength = STREAM_PACKED_MAX + 1;
+    if (sequence % STREAM_KEY_INTERVAL != 0) {
+      for (uint16_t i = 0; i < STREAM_BINS; i++) {
+        int change = levels[i] - reference[i];
+        changes[i] = abs(change) <= STREAM_DEADBAND ? 0 : (uint8_t)change;
+      }
+      deltaLength = packBits(changes, STREAM_BINS, packed);
+    }
+
+    last = STREAM_KEY;
+    uint16_t length = keyLength;
+    if (deltaLength < keyLength) {
+      last = STREAM_DELTA;
+      length = deltaLength;
+      memcpy(keyData, packed, deltaLength);
+      for (uint16_t i = 0; i < STREAM_BINS; i++) reference[i] += changes[i];
+    } else memcpy(reference, levels, STREAM_BINS);
+
+    PayloadWriter w = {payload, STREAM_HEADER_BYTES, 0};
+    w.u32(sequence++);
+    w.u8(last);
+    w.u16(STREAM_BINS);
+    w.u16(centiHzPerBin);
+    return STREAM_HEADER_BYTES + length;
+  }
+
+  /**
+   * @brief Gets the kind of the last frame.
+   * @return STREAM_KEY or STREAM_DELTA.
+   */
+  StreamFrameKind lastKind() const {
+    return last;
+  }
+};
+
+/**
+ * @class SpectrumStreamDecoder
+ * @brief Rebuilds the quantized spectra of a stream.
+ */
+class SpectrumStreamDecoder {
+private:
+  uint8_t changes[STREAM_BINS]; /**< Unpacked frame. */
+  uint32_t expected = 0; /**< Sequence of the next delta frame. */
+  bool synced = false; /**< False until a key frame, and after a lost frame. */
+
+public:
+  uint8_t levels[STREAM_BINS]; /**< Last spectrum, quantized. */
+  uint32_t sequence = 0; /**< Sequence of the last spectrum. */
+  float hzPerBin = 0; /**< Hz per bin of the last spectrum. */
+  unsigned long lost = 0; /**< Delta frames skipped waiting for a key frame. */
+
+  /**
+   * @brief Decodes the payload of a SERIAL_FRAME_SPECTRUM frame.
+   * @param p The payload.
+   * @return True if levels holds a new spectrum.
+   */
+  bool decode(PayloadReader p) {
+    uint32_t s = p.u32();
+    uint8_t kind = p.u8();
+    uint16_t bins = p.u16();
+    uint16_t centiHz = p.u16();
+    if (p.overrun or bins != STREAM_BINS or kind > STREAM_DELTA) return false;
+    if (kind == STREAM_DELTA and (!synced or s != expected)) {
+      synced = false;
+      lost++;
+      return false;
+    }
+    if (!unpackBits(p.data + p.position, p.length - p.position, changes, STREAM_BINS)) {
+      synced = false;
+      return false;
+    }
+
+    if (kind == STREAM_KEY) memcpy(levels, changes, STREAM_BINS);
+    else for (uint16_t i = 0; i < STREAM_BINS; i++) levels[i] += changes[i];
+    synced = true;
+    sequence = s;
+    expected = s + 1;
+    hzPerBin = centiHz / 100.0f;
+    return true;
+  }
+};
+
+// ---------- Code --------------
+uint8_t quantizeMagnitude(float magnitude) {
+  if (magnitude < 1.0f) return 0;
+  float level = 20.0f * log10f(magnitude) / STREAM_DB_STEP + 0.5f;
+  return level > 255.0f ? 255 : (uint8_t)level;
+}
+
+uint16_t packBits(const uint8_t *in, uint16_t n, uint8_t *out) {
+  uint16_t length = 0;
+  uint16_t i = 0;
+  while (i < n) {
+    uint16_t run = 1;
+    while (i + run < n and run < 128 and in[i + run] == in[i]) run++;
+    if (run >= 3) {
+      out[length++] = (uint8_t)(257 - run);
+      out[length++] = in[i];
+      i += run;
+      continue;
+    }
+
+    // Literals up to the next run of 3, shorter runs don't save bytes.
+    uint16_t j = i + 1;
+    while (j < n and j - i < 128 and !(j + 2 < n and in[j] == in[j + 1] and in[j] == in[j + 2])) j++;
+    out[length++] = (uint8_t)(j - i - 1);
+    memcpy(out + length, in + i, j - i);
+    length += j - i;
+    i = j;
+  }
+  return length;
+}
+
+bool unpackBits(const uint8_t *in, uint16_t length, uint8_t *out, uint16_t n) {
+  uint16_t i = 0, o = 0;
+  while (i < length) {
+    uint8_t c = in[i++];
+    if (c < 128) {
+      uint16_t count = c + 1;
+      if (i + count > length or o + count > n) return false;
+      memcpy(out + o, in + i, count);
+      i += count;
+      o += count;
+    } else {
+      uint16_t count = 257 - c;
+      if (i >= length or o + count > n) return false;
+      memset(out + o, in[i++], count);
+      o += count;
+    }
+  }
+  return o == n;
+}
+
+// Host tools only need the format above.
+#ifndef SPECTRUM_STREAM_FORMAT_ONLY
+
+#include "Arduino.h"
+#include "display.h"
+#include "textOverlay.h"
+#include "frameGovernor.h"
+#include "spectrumBus.h"
+
+static_assert(STREAM_BINS <= BUS_SAMPLES / 2, "Streamed bins past the Nyquist bin");
+
+// ---------- Struct Definition --------------
+/**
+ * @brief State of the spectrum stream mode.
+ */
+struct SpectrumStreamState {
+  SpectrumStreamEncoder encoder; /**< Decoder copy of the spectrum. */
+  uint8_t levels[STREAM_BINS]; /**< Quantized spectrum of the capture. */
+  uint8_t payload[STREAM_HEADER_BYTES + STREAM_PACKED_MAX]; /**< Frame being sent. */
+  unsigned long frames; /**< Frames sent. */
+  unsigned long keys; /**< Key frames sent. */
+  unsigned long bytes; /**< Bytes sent, framing included. */
+};
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Initializes the spectrum stream mode. The first frame is a key frame.
+ * @param state The mode state.
+ */
+void initSpectrumStream(SpectrumStreamState &state);
+
+/**
+ * @brief Sends the spectrum of the last capture and shows the stream counters.
+ * @param state The mode state.
+ * @param frame The last capture.
+ */
+void displaySpectrumStream(SpectrumStreamState &state, const BusFrame &frame);
+
+// ---------- Code --------------
+void initSpectrumStream(SpectrumStreamState &state) {
+  display.clearDisplay();
+  display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+  drawCenteredText(DISPLAY_WIDTH / 2, 0, "Spectrum Stream");
+  drawText(0, FONT_HEIGHT * 2, "Serial 115200 baud");
+}
+
+void displaySpectrumStream(SpectrumStreamState &state, const BusFrame &frame) {
+  float sum = 0;
+  for (uint16_t i = 0; i < STREAM_BINS; i++) sum += cabsf(frame.spectrum[i]);
+  float gate = STREAM_GATE * sum / STREAM_BINS;
+  for (uint16_t i = 0; i < STREAM_BINS; i++) {
+    float magnitude = cabsf(frame.spectrum[i]);
+    state.levels[i] = magnitude < gate ? 0 : quantizeMagnitude(magnitude);
+  }
+  uint16_t length = state.encoder.encode(state.levels, (uint16_t)(BUS_HZ_PER_BIN * 100.0f + 0.5f), state.payload);
+  writeSerialFrame(Serial, SERIAL_FRAME_SPECTRUM, state.payload, length);
+  state.frames++;
+  state.keys += state.encoder.lastKind() == STREAM_KEY;
+  state.bytes += length + SERIAL_FRAME_OVERHEAD;
+  if (!governorRender()) return;
+
+  TextLine text;
+  display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+  drawText(0, FONT_HEIGHT * 3, text.add("Frames: ").addInt(state.frames).c_str());
+  drawText(0, FONT_HEIGHT * 4, text.clear().add("Keys: ").addInt(state.keys).c_str());
+  drawText(0, FONT_HEIGHT * 5, text.clear().add("Bytes/frame: ").addInt(state.bytes / state.frames, 4).c_str());
+}
+
+#endif
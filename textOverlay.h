@@ -0,0 +1,215 @@
+/**
+ * @file textOverlay.h
+ * @brief Allocation-free text overlay
+ *
+ * This file contains the text tools of the per-frame readouts. Arduino String objects
+ * allocate on the heap each time they are built or concatenated, which fragments the
+ * heap of a device that runs for weeks. TextLine is a fixed-capacity char buffer with
+ * integer and fixed-point formatting that doesn't use the heap nor printf.
+ *
+ * Static labels (axes, units) are drawn once when a mode starts; the modes clear only
+ * their graph area afterwards, so the labels are never redrawn.
+ *
+ * The heap probe counts the heap allocations (malloc calls, not live blocks: a String
+ * built and freed within a frame counts) of each frame, which should be zero. The calls
+ * are counted by an allocation hook: on the device the ESP-IDF heap hook, compiled when
+ * the core is built with CONFIG_HEAP_USE_HOOKS (without it the counter stays at 0), and on
+ * the host the malloc of the tool that checks it (host/modeBench.cpp).
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include "Arduino.h"
+#include "display.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+/**
+ * @brief Capacity of a text line, NUL included. A 128 px line fits 21 characters.
+ */
+const unsigned char TEXT_CAPACITY = 22;
+
+/**
+ * @brief Fixed-capacity text line. Characters that don't fit are dropped.
+ */
+struct TextLine {
+  char text[TEXT_CAPACITY]; /**< Characters, NUL terminated. */
+  unsigned char length; /**< Number of characters. */
+
+  /**
+   * @brief Constructs an empty line.
+   */
+  TextLine() : length(0) {
+    text[0] = '\0';
+  }
+
+  /**
+   * @brief Empties the line.
+   * @return The line, to chain calls.
+   */
+  TextLine &clear() {
+    length = 0;
+    text[0] = '\0';
+    return *this;
+  }
+
+  /**
+   * @brief Appends a character.
+   * @param c The character.
+   * @return The line, to chain calls.
+   */
+  TextLine &add(char c) {
+    if (length < TEXT_CAPACITY - 1) text[length++] = c;
+    text[length] = '\0';
+    return *this;
+  }
+
+  /**
+   * @brief Appends a string.
+   * @param s The string.
+   * @return The line, to chain calls.
+   */
+  TextLine &add(const char *s) {
+    while (*s != '\0' and length < TEXT_CAPACITY - 1) text[length++] = *s++;
+    text[length] = '\0';
+    return *this;
+  }
+
+  /**
+   * @brief Appends an integer in decimal.
+   * @param v The value.
+   * @param width Minimum width, right aligned with spaces.
+   * @return The line, to chain calls.
+   */
+  TextLine &addInt(long v, unsigned char width = 0) {
+    char digits[12];
+    unsigned char n = 0;
+    unsigned long u = v < 0 ? 0ul - (unsigned long)v : (unsigned long)v;
+    do {
+      digits[n++] = '0' + (u % 10);
+      u /= 10;
+    } while (u > 0);
+    if (v < 0) digits[n++] = '-';
+    for (unsigned char i = n; i < width; i++) add(' ');
+    while (n > 0) add(digits[--n]);
+    return *this;
+  }
+
+  /**
+   * @brief Appends a number with a fixed number of decimals, like String(float).
+   * @param v The value.
+   * @param decimals Number of decimals (0 to 4).
+   * @return The line, to chain calls.
+   */
+  TextLine &addFixed(double v, unsigned char decimals = 2) {
+    long scale = 1;
+    for (unsigned char i = 0; i < decimals; i++) scale *= 10;
+    long long scaled = (long long)(v * scale + (v < 0 ? -0.5 : 0.5));
+    if (scaled < 0) {
+      add('-');
+      scaled = -scaled;
+    }
+    addInt((long)(scaled / scale));
+    if (decimals > 0) {
+      add('.');
+      long fraction = scaled % scale;
+      for (long d = scale / 10; d > 0; d /= 10) {
+        add('0' + (fraction / d) % 10);
+      }
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Gets the text.
+   * @return NUL terminated characters.
+   */
+  const char *c_str() const {
+    return text;
+  }
+};
+
+/**
+ * @namespace heapProbe
+ * @brief Namespace for the heap allocation counter of the frames.
+ */
+namespace heapProbe {
+  volatile unsigned long allocations = 0; /**< Heap allocations, counted by the allocation hook. */
+  unsigned long frameStart = 0; /**< Counter at the start of the frame. */
+  unsigned long lastFrame = 0; /**< Allocations of the last frame. */
+}
+
+// ---------------- Headers ----------------------
+/**
+ * @brief Draws a text at a position.
+ * @param x Column of the first character.
+ * @param y Top row.
+ * @param text The text.
+ */
+void drawText(short x, short y, const char *text);
+
+/**
+ * @brief Draws a text centered on a column.
+ * @param xCenter Center column.
+ * @param y Top row.
+ * @param text The text.
+ */
+void drawCenteredText(short xCenter, short y, const char *text);
+
+/**
+ * @brief Gets the heap allocation counter.
+ * @return Heap allocations counted by the allocation hook since the start.
+ */
+unsigned long heapAllocations();
+
+/**
+ * @brief Starts counting the heap allocations of a frame.
+ */
+void heapProbeStart();
+
+/**
+ * @brief Ends the frame.
+ * @return Heap allocations since heapProbeStart().
+ */
+unsigned long heapProbeEnd();
+
+// ---------------- Code ----------------------
+void drawText(short x, short y, const char *text) {
+  display.setCursor(x, y);
+  display.print(text);
+}
+
+void drawCenteredText(short xCenter, short y, const char *text) {
+  drawText(xCenter - ((FONT_WIDTH * strlen(text)) / 2), y, text);
+}
+
+#if defined(ESP_PLATFORM) && defined(CONFIG_HEAP_USE_HOOKS)
+/**
+ * @brief ESP-IDF hook, called by every successful heap allocation.
+ * @param ptr The block.
+ * @param size Bytes requested.
+ * @param caps Capabilities of the heap.
+ */
+extern "C" void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+  heapProbe::allocations++;
+}
+#endif
+
+unsigned long heapAllocations() {
+  return heapProbe::allocations;
+}
+
+void heapProbeStart() {
+  heapProbe::frameStart = heapAllocations();
+}
+
+unsigned long heapProbeEnd() {
+  unsigned long now = heapAllocations();
+  heapProbe::lastFrame = now > heapProbe::frameStart ? now - heapProbe::frameStart : 0;
+  return heapProbe::lastFrame;
+}
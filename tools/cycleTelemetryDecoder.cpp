@@ -0,0 +1,120 @@
+/**
+ * @file cycleTelemetryDecoder.cpp
+ * @brief Cycle telemetry decoder
+ *
+ * Host tool that pretty-prints the cycle telemetry frames (see cycleTelemetry.h) found in
+ * a Serial stream: a capture file, the serial device itself or stdin. Text lines and
+ * corrupted frames in the stream are skipped.
+ *
+ * For each frame and stage it prints the count, min, average and max in us, an estimate of
+ * the p50 and p99 from the histogram (upper edge of the bucket) and the histogram itself.
+ *
+ * Build: g++ -O2 -o cycleTelemetryDecoder tools/cycleTelemetryDecoder.cpp
+ * Usage: stty -F /dev/ttyUSB0 115200 raw && cycleTelemetryDecoder /dev/ttyUSB0
+ *        cycleTelemetryDecoder capture.bin
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#define SERIAL_FRAME_FORMAT_ONLY
+#include "../serialFrame.h"
+#include "../cycleTelemetry.h"
+
+/**
+ * @brief Width of the longest histogram bar.
+ */
+const unsigned char BAR_WIDTH = 40;
+
+/**
+ * @brief Gets the upper edge of the bucket that holds a fraction of the measures.
+ * @param buckets Measures of each bucket, from first.
+ * @param n Number of buckets.
+ * @param first First bucket.
+ * @param fraction Fraction of the measures, 0 to 1.
+ * @return Upper edge in ticks.
+ */
+double bucketPercentile(const uint16_t *buckets, unsigned char n, unsigned char first, double fraction) {
+  unsigned long total = 0;
+  for (unsigned char b = 0; b < n; b++) total += buckets[b];
+  unsigned long seen = 0;
+  for (unsigned char b = 0; b < n; b++) {
+    seen += buckets[b];
+    if (seen >= fraction * total) return (double)(1ull << (first + b));
+  }
+  return (double)(1ull << (first + n));
+}
+
+/**
+ * @brief Prints a telemetry frame.
+ * @param p Payload of the frame.
+ * @return False if the payload is truncated.
+ */
+bool printCycles(PayloadReader p) {
+  unsigned sequence = p.u16();
+  double ticksPerUs = p.u16();
+  unsigned long periodMs = p.u32();
+  unsigned char stages = p.u8();
+  if (ticksPerUs == 0) ticksPerUs = 1;
+
+  printf("frame %u: %lu ms, %.0f ticks/us\n", sequence, periodMs, ticksPerUs);
+  printf("  %-8s %8s %10s %10s %10s %10s %10s\n", "stage", "count", "min_us", "avg_us", "max_us", "p50_us", "p99_us");
+  for (unsigned char s = 0; s < stages; s++) {
+    unsigned char stage = p.u8();
+    unsigned long count = p.u32();
+    double minimum = p.u32() / ticksPerUs;
+    double maximum = p.u32() / ticksPerUs;
+    double sum = p.u64() / ticksPerUs;
+    unsigned char first = p.u8();
+    unsigned char n = p.u8();
+    uint16_t buckets[CYCLE_BUCKETS] = {0};
+    for (unsigned char b = 0; b < n; b++) {
+      uint16_t v = p.u16();
+      if (b < CYCLE_BUCKETS) buckets[b] = v;
+    }
+    if (p.overrun or n > CYCLE_BUCKETS) return false;
+
+    const char *name = stage < N_CYCLE_STAGES ? CYCLE_STAGE_NAMES[stage] : "?";
+    printf("  %-8s %8lu %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, count, minimum, count > 0 ? sum / count : 0, maximum,
+           bucketPercentile(buckets, n, first, 0.5) / ticksPerUs, bucketPercentile(buckets, n, first, 0.99) / ticksPerUs);
+
+    uint16_t most = 1;
+    for (unsigned char b = 0; b < n; b++) if (buckets[b] > most) most = buckets[b];
+    for (unsigned char b = 0; b < n; b++) {
+      char bar[BAR_WIDTH + 1];
+      unsigned char width = (unsigned long)buckets[b] * BAR_WIDTH / most;
+      memset(bar, '#', width);
+      bar[width] = '\0';
+      printf("    < %10.1f us %6u %s\n", (double)(1ull << (first + b)) / ticksPerUs, buckets[b], bar);
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 2) {
+    fprintf(stderr, "Usage: %s [capture file or serial device]\n", argv[0]);
+    return 2;
+  }
+  FILE *in = argc == 2 ? fopen(argv[1], "rb") : stdin;
+  if (in == nullptr) {
+    fprintf(stderr, "Can't read %s\n", argv[1]);
+    return 1;
+  }
+
+  static SerialFrameReader reader;
+  unsigned long frames = 0;
+  int c;
+  while ((c = fgetc(in)) != EOF) {
+    if (!reader.feed(c) or reader.type() != SERIAL_FRAME_CYCLES) continue;
+    if (printCycles(reader.data())) frames++;
+    else fprintf(stderr, "Truncated telemetry frame\n");
+    fflush(stdout);
+  }
+  fprintf(stderr, "%lu frames, %lu dropped\n", frames, reader.droppedFrames());
+  if (in != stdin) fclose(in);
+  return 0;
+}
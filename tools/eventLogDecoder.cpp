@@ -0,0 +1,79 @@
+/**
+ * @file eventLogDecoder.cpp
+ * @brief Event log decoder
+ *
+ * Host tool that dumps a detection event log (see eventLog.h) to CSV. The input is a raw
+ * image of the log storage: the eventlog.bin file of the host backend, or a dump of the
+ * flash partition of the device:
+ *
+ *   esptool.py read_flash <partition offset> <partition size> eventlog.bin
+ *
+ * Records are printed from the oldest to the newest.
+ *
+ * Build: g++ -O2 -o eventLogDecoder tools/eventLogDecoder.cpp
+ * Usage: eventLogDecoder eventlog.bin > events.csv
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#define EVENT_LOG_FORMAT_ONLY
+#include "../eventLog.h"
+
+/**
+ * @brief Frequency of one bin of the listening FFT, same calibration as showListeningInfo().
+ */
+const double HZ_PER_BIN = 15.2256;
+
+/**
+ * @brief Reads every valid record of a log image.
+ * @param path Path of the image.
+ * @param records Vector to store the records.
+ * @return False if the file can't be read.
+ */
+bool readRecords(const char *path, std::vector<EventRecord> &records) {
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr) return false;
+
+  EventRecord r;
+  while (fread(&r, sizeof(r), 1, file) == 1) {
+    if (r.sequence != EVENT_LOG_EMPTY) records.push_back(r);
+  }
+  fclose(file);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s <event log image>\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<EventRecord> records;
+  if (!readRecords(argv[1], records)) {
+    fprintf(stderr, "Can't read %s\n", argv[1]);
+    return 1;
+  }
+
+  std::sort(records.begin(), records.end(), [](const EventRecord &a, const EventRecord &b) {
+    return a.sequence < b.sequence;
+  });
+
+  printf("sequence,timestamp_s,alert_id,peak_bin,frequency_hz,intensity,snr_db\n");
+  for (const EventRecord &r : records) {
+    printf("%lu,%lu,%u,%u,%.1f,%lu,%d\n",
+      (unsigned long)r.sequence,
+      (unsigned long)r.timestamp,
+      (unsigned)r.alertId,
+      (unsigned)r.peakBin,
+      r.peakBin * HZ_PER_BIN,
+      (unsigned long)r.intensity,
+      (int)r.snr);
+  }
+  return 0;
+}
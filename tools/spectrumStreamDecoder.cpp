@@ -0,0 +1,133 @@
+/**
+ * @file spectrumStreamDecoder.cpp
+ * @brief Spectrum stream decoder
+ *
+ * Host tool that decodes the spectrum stream of the Spectrum Stream mode (see
+ * spectrumStream.h) into a scrolling spectrogram: a PGM image with one row per spectrum,
+ * the newest at the bottom, and one column per bin (0 Hz on the left). The image is
+ * written again after every spectrum (to a temporary file and renamed), so a viewer that
+ * reloads it shows the live spectrogram.
+ *
+ * The input is the serial device, a capture or stdin. Text lines, corrupted frames and the
+ * other binary frames are skipped; after a lost frame the spectra wait for the next key
+ * frame.
+ *
+ * Build: g++ -O2 -o spectrumStreamDecoder tools/spectrumStreamDecoder.cpp
+ * Usage: stty -F /dev/ttyUSB0 115200 raw && spectrumStreamDecoder -o spectrogram.pgm /dev/ttyUSB0
+ *        spectrumStreamDecoder [-o image] [-n rows] [-f floor dB] [-r range dB] [input]
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define SERIAL_FRAME_FORMAT_ONLY
+#define SPECTRUM_STREAM_FORMAT_ONLY
+#include "../spectrumStream.h"
+
+/**
+ * @brief Default rows of the spectrogram.
+ */
+const unsigned short DEFAULT_ROWS = 256;
+
+/**
+ * @brief Default level (dB) drawn black.
+ */
+const float DEFAULT_FLOOR_DB = 40;
+
+/**
+ * @brief Default levels (dB) from black to white.
+ */
+const float DEFAULT_RANGE_DB = 80;
+
+/**
+ * @brief Writes the spectrogram as a binary PGM.
+ * @param path Path of the image.
+ * @param rows Rows of the spectrogram, circular.
+ * @param newest Next row to overwrite, the oldest one.
+ * @param count Rows in use.
+ * @return False if the image can't be written.
+ */
+bool writeSpectrogram(const char *path, const std::vector<uint8_t> &rows, size_t newest, size_t count) {
+  std::string temporary = std::string(path) + ".tmp";
+  FILE *file = fopen(temporary.c_str(), "wb");
+  if (file == nullptr) return false;
+
+  size_t capacity = rows.size() / STREAM_BINS;
+  fprintf(file, "P5\n%u %zu\n255\n", STREAM_BINS, count);
+  for (size_t r = 0; r < count; r++) {
+    size_t row = (newest + capacity - count + r) % capacity;
+    fwrite(rows.data() + row * STREAM_BINS, 1, STREAM_BINS, file);
+  }
+  if (fclose(file) != 0) return false;
+  return rename(temporary.c_str(), path) == 0;
+}
+
+int main(int argc, char **argv) {
+  const char *imagePath = "spectrogram.pgm";
+  const char *inputPath = nullptr;
+  size_t capacity = DEFAULT_ROWS;
+  float floorDb = DEFAULT_FLOOR_DB;
+  float rangeDb = DEFAULT_RANGE_DB;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-o") == 0 and i + 1 < argc) imagePath = argv[++i];
+    else if (strcmp(argv[i], "-n") == 0 and i + 1 < argc) capacity = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-f") == 0 and i + 1 < argc) floorDb = atof(argv[++i]);
+    else if (strcmp(argv[i], "-r") == 0 and i + 1 < argc) rangeDb = atof(argv[++i]);
+    else if (argv[i][0] != '-' and inputPath == nullptr) inputPath = argv[i];
+    else {
+      fprintf(stderr, "Usage: %s [-o image] [-n rows] [-f floor dB] [-r range dB] [input]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (capacity == 0 or rangeDb <= 0) {
+    fprintf(stderr, "Rows and range must be positive\n");
+    return 2;
+  }
+
+  FILE *in = inputPath != nullptr ? fopen(inputPath, "rb") : stdin;
+  if (in == nullptr) {
+    fprintf(stderr, "Can't read %s\n", inputPath);
+    return 1;
+  }
+
+  // Gray of each level.
+  uint8_t gray[256];
+  for (int level = 0; level < 256; level++) {
+    float g = (level * STREAM_DB_STEP - floorDb) * 255.0f / rangeDb;
+    gray[level] = g < 0 ? 0 : (g > 255 ? 255 : (uint8_t)g);
+  }
+
+  static SerialFrameReader reader;
+  static SpectrumStreamDecoder decoder;
+  std::vector<uint8_t> rows(capacity * STREAM_BINS);
+  size_t newest = 0, count = 0;
+  unsigned long spectra = 0, keys = 0, bytes = 0;
+  int c;
+  while ((c = fgetc(in)) != EOF) {
+    if (!reader.feed(c) or reader.type() != SERIAL_FRAME_SPECTRUM) continue;
+    PayloadReader payload = reader.data();
+    if (!decoder.decode(payload)) continue;
+
+    spectra++;
+    keys += payload.data[4] == STREAM_KEY;
+    bytes += payload.length + SERIAL_FRAME_OVERHEAD;
+    for (uint16_t i = 0; i < STREAM_BINS; i++) rows[newest * STREAM_BINS + i] = gray[decoder.levels[i]];
+    newest = (newest + 1) % capacity;
+    if (count < capacity) count++;
+    if (!writeSpectrogram(imagePath, rows, newest, count)) {
+      fprintf(stderr, "Can't write %s\n", imagePath);
+      return 1;
+    }
+  }
+
+  fprintf(stderr, "%lu spectra (%lu key frames), %.1f bytes per spectrum, %.2f Hz per bin, %lu waiting for a key frame, %lu dropped\n",
+          spectra, keys, spectra > 0 ? (double)bytes / spectra : 0.0, decoder.hzPerBin, decoder.lost, reader.droppedFrames());
+  if (in != stdin) fclose(in);
+  return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file waterfallBench.cpp
+ * @brief Waterfall transfer benchmark
+ *
+ * Host tool that measures the bytes sent to the OLED panel for each new spectrogram
+ * column, with the same transfer planning as the device (see panelTransfer.h):
+ *
+ * - full: Adafruit_SSD1306::display(), the whole framebuffer on every column.
+ * - pages: one window per dirty page, horizontal addressing.
+ * - vertical: windows of several pages in vertical addressing mode.
+ *
+ * The sweeping view writes the new column, the cursor and 3 blank columns; the running
+ * view shifts the whole waterfall one column. The columns are synthetic: a chirp over
+ * random background bins.
+ *
+ * Build: g++ -O2 -o waterfallBench tools/waterfallBench.cpp
+ * Usage: waterfallBench [columns] [bytes per I2C transmission]
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../panelTransfer.h"
+
+/**
+ * @brief Width of the panel.
+ */
+const unsigned short WIDTH = 128;
+
+/**
+ * @brief Pages of the panel (64 rows).
+ */
+const unsigned char PAGES = 8;
+
+/**
+ * @brief First column of the graph, after the axis labels.
+ */
+const unsigned short GRAPH_X = 6;
+
+/**
+ * @brief Makes a synthetic spectrogram column.
+ * @param n Column number.
+ * @param pages Output column, PAGES bytes.
+ */
+void makeColumn(unsigned long n, unsigned char *pages) {
+  memset(pages, 0, PAGES);
+  short chirp = 63 - (n % 64); // Rising tone, one row per column.
+  pages[chirp / 8] |= 1 << (chirp % 8);
+  for (unsigned char i = 0; i < 3; i++) { // Background bins.
+    short row = rand() % 64;
+    pages[row / 8] |= 1 << (row % 8);
+  }
+}
+
+/**
+ * @brief Writes a column in a framebuffer.
+ * @param frame The framebuffer.
+ * @param x The column, ignored if off the screen.
+ * @param pages The column, PAGES bytes.
+ */
+void writeColumn(unsigned char *frame, short x, const unsigned char *pages) {
+  if (x < 0 or x >= WIDTH) return;
+  for (unsigned char page = 0; page < PAGES; page++) frame[page * WIDTH + x] = pages[page];
+}
+
+/**
+ * @brief Runs the sweeping view.
+ * @param transfer Transfer planner of the strategy.
+ * @param columns Number of columns.
+ * @return Bytes sent per column.
+ */
+double sweeping(PanelTransfer &transfer, unsigned long columns) {
+  static const unsigned char cursor[PAGES] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  static const unsigned char blank[PAGES] = {0};
+  unsigned char frame[WIDTH * PAGES] = {0};
+  unsigned char column[PAGES];
+  transfer.flush(frame, [](const PanelWindow &) {});
+
+  srand(1);
+  unsigned long bytes = 0;
+  for (unsigned long n = 0; n < columns; n++) {
+    short x = GRAPH_X + n % (WIDTH - GRAPH_X);
+    makeColumn(n, column);
+    writeColumn(frame, x, column);
+    writeColumn(frame, x + 1, cursor);
+    for (short j = 2; j <= 4; j++) writeColumn(frame, x + j, blank);
+    transfer.markDirty(x, x + 4 < WIDTH ? x + 4 : WIDTH - 1, 0, PAGES - 1);
+    bytes += transfer.flush(frame, [](const PanelWindow &) {});
+  }
+  return (double)bytes / columns;
+}
+
+/**
+ * @brief Runs the running view, newest column on the left.
+ * @param transfer Transfer planner of the strategy.
+ * @param columns Number of columns.
+ * @return Bytes sent per column.
+ */
+double running(PanelTransfer &transfer, unsigned long columns) {
+  unsigned char frame[WIDTH * PAGES] = {0};
+  unsigned char column[PAGES];
+  transfer.flush(frame, [](const PanelWindow &) {});
+
+  srand(1);
+  unsigned long bytes = 0;
+  for (unsigned long n = 0; n < columns; n++) {
+    for (unsigned char page = 0; page < PAGES; page++) {
+      unsigned char *row = frame + page * WIDTH;
+      memmove(row + GRAPH_X + 1, row + GRAPH_X, WIDTH - GRAPH_X - 1);
+    }
+    makeColumn(n, column);
+    writeColumn(frame, GRAPH_X, column);
+    transfer.markDirty(GRAPH_X, WIDTH - 1, 0, PAGES - 1);
+    bytes += transfer.flush(frame, [](const PanelWindow &) {});
+  }
+  return (double)bytes / columns;
+}
+
+int main(int argc, char *argv[]) {
+  unsigned long columns = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000;
+  unsigned short chunk = argc > 2 ? atoi(argv[2]) : PANEL_WIRE_MAX;
+  if (columns == 0 or chunk < 2) {
+    fprintf(stderr, "Usage: %s [columns] [bytes per I2C transmission]\n", argv[0]);
+    return 1;
+  }
+
+  PanelTransfer full(WIDTH, PAGES, chunk);
+  double fullBytes = full.windowCost(WIDTH * PAGES);
+
+  printf("view,full,pages,vertical\n");
+  PanelTransfer pages(WIDTH, PAGES, chunk);
+  pages.multiPageWindows(false);
+  PanelTransfer vertical(WIDTH, PAGES, chunk);
+  double sweepPages = sweeping(pages, columns);
+  double sweepVertical = sweeping(vertical, columns);
+  printf("sweeping,%.1f,%.1f,%.1f\n", fullBytes, sweepPages, sweepVertical);
+
+  double runPages = running(pages, columns);
+  double runVertical = running(vertical, columns);
+  printf("running,%.1f,%.1f,%.1f\n", fullBytes, runPages, runVertical);
+  return 0;
+}
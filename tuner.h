@@ -0,0 +1,127 @@
+/**
+ * @file tuner.h
+ * @brief Tuner display mode
+ *
+ * This file contains the Tuner mode: the pitch of the captures (see pitchDetector.h) as
+ * the nearest note of the equal temperament (A4 = 440 Hz), its frequency and a needle
+ * with the deviation in cents. The last voiced pitch is held for TUNER_HOLD_MS, so the
+ * needle doesn't blink between the notes of a melody.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <math.h>
+#include "Arduino.h"
+#include "display.h"
+#include "textOverlay.h"
+#include "frameGovernor.h"
+#include "spectrumBus.h"
+
+// ---------- Constants --------------
+/**
+ * @brief Frequency of A4 (Hz).
+ */
+const float TUNER_A4_HZ = 440.0f;
+
+/**
+ * @brief Time the last voiced pitch is shown (ms).
+ */
+const unsigned long TUNER_HOLD_MS = 500ul;
+
+/**
+ * @brief Weight of a new capture in the mean pitch of a note.
+ */
+const float TUNER_SMOOTHING = 0.5f;
+
+/**
+ * @brief Pixels per cent of the needle, +-50 cents over the display width.
+ */
+const float TUNER_PIXELS_PER_CENT = (DISPLAY_WIDTH - 8) / 100.0f;
+
+/**
+ * @brief Names of the notes from C.
+ */
+const char *const TUNER_NOTE_NAMES[12] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+
+// ---------- Struct Definition --------------
+/**
+ * @brief State of the tuner mode.
+ */
+struct TunerState {
+  float midi; /**< Mean pitch of the current note, in MIDI note numbers (fractional). */
+  float hz; /**< Mean pitch of the current note (Hz). */
+  unsigned long voicedAt; /**< Time of the last voiced capture (ms), 0 if none. */
+};
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Initializes the tuner mode, nothing to draw.
+ * @param state The mode state.
+ */
+void initTuner(TunerState &state);
+
+/**
+ * @brief Follows the pitch of the capture and, when a frame is due, shows the note.
+ * @param state The mode state.
+ * @param frame The last capture.
+ */
+void displayTuner(TunerState &state, const BusFrame &frame);
+
+// ---------- Code --------------
+void initTuner(TunerState &state) {
+  display.clearDisplay();
+}
+
+void displayTuner(TunerState &state, const BusFrame &frame) {
+  const PitchEstimate &pitch = frame.pitch;
+  if (pitch.voiced) {
+    float midi = 69.0f + 12.0f * log2f(pitch.hz / TUNER_A4_HZ);
+    bool sameNote = state.voicedAt > 0 and lroundf(midi) == lroundf(state.midi);
+    state.midi = sameNote ? state.midi + TUNER_SMOOTHING * (midi - state.midi) : midi;
+    state.hz = TUNER_A4_HZ * exp2f((state.midi - 69.0f) / 12.0f);
+    state.voicedAt = millis();
+  }
+  if (!governorRender()) return;
+
+  const short scaleY = DISPLAY_HEIGHT - 10;
+  const short center = DISPLAY_WIDTH / 2;
+  TextLine text;
+  display.clearDisplay();
+  display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+
+  // Scale: +-50 cents, a tick every 10 and a longer one at 0.
+  display.drawFastHLine(center - 50 * TUNER_PIXELS_PER_CENT, scaleY, 100 * TUNER_PIXELS_PER_CENT + 1, SSD1306_WHITE);
+  for (short c = -50; c <= 50; c += 10) {
+    short h = c == 0 ? 7 : 3;
+    display.drawFastVLine(center + c * TUNER_PIXELS_PER_CENT, scaleY - h, h, SSD1306_WHITE);
+  }
+
+  bool held = state.voicedAt > 0 and millis() - state.voicedAt <= TUNER_HOLD_MS;
+  if (!held) {
+    display.setTextSize(3);
+    drawText(center - FONT_WIDTH * 3, 0, "--");
+    display.setTextSize(1);
+    drawText(0, FONT_HEIGHT * 3 + 2, text.add("Clarity: ").addFixed(pitch.clarity).c_str());
+    return;
+  }
+
+  long note = lroundf(state.midi);
+  short cents = lroundf((state.midi - note) * 100.0f);
+  text.add(TUNER_NOTE_NAMES[((note % 12) + 12) % 12]).addInt(note / 12 - 1);
+  display.setTextSize(3);
+  drawText(center - FONT_WIDTH * 3 * strlen(text.c_str()) / 2, 0, text.c_str());
+  display.setTextSize(1);
+  drawText(0, FONT_HEIGHT * 3 + 2, text.clear().addFixed(state.hz, 1).add(" Hz").c_str());
+  text.clear();
+  if (cents > 0) text.add('+');
+  text.addInt(cents).add(" cent");
+  drawText(DISPLAY_WIDTH - FONT_WIDTH * strlen(text.c_str()), FONT_HEIGHT * 3 + 2, text.c_str());
+
+  // Needle, 3 px wide, filled within 5 cents.
+  short x = center + cents * TUNER_PIXELS_PER_CENT;
+  display.fillRect(x - 1, scaleY - 8, 3, 9, SSD1306_WHITE);
+  if (abs(cents) <= 5) display.fillRect(center - 5, DISPLAY_HEIGHT - 7, 11, 7, SSD1306_WHITE);
+}
@@ -0,0 +1,110 @@
+/**
+ * @file waterfall.h
+ * @brief Bit-packed waterfall buffer
+ *
+ * This file contains the storage of the running spectrogram. Each spectrum column is
+ * quantized to 1 bit per pixel and packed in page-aligned bytes (8 bytes for 64 rows),
+ * the same layout as the SSD1306 framebuffer: bit k of page p is row p * 8 + k.
+ *
+ * The columns are kept in a circular buffer with a moving head, so adding a column is
+ * O(1) and rendering the whole waterfall is one byte copy per page and column, straight
+ * into the framebuffer.
+ *
+ * @author Nahum Manuel Martín
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <string.h>
+#include <complex.h>
+#include "display.h"
+
+// ---------- Constants --------------
+/**
+ * @brief Number of 8-row pages of the display.
+ */
+const unsigned char WATERFALL_PAGES = DISPLAY_HEIGHT / 8;
+
+/**
+ * @brief Maximum number of columns stored.
+ */
+const unsigned short WATERFALL_COLUMNS = DISPLAY_WIDTH;
+
+// ---------- Struct Definition --------------
+/**
+ * @brief Circular buffer of bit-packed columns.
+ */
+struct Waterfall {
+  unsigned char columns[WATERFALL_COLUMNS][WATERFALL_PAGES]; /**< Packed columns. */
+  unsigned short head; /**< Slot of the next column. */
+
+  /**
+   * @brief Clears every column.
+   */
+  void clear() {
+    memset(columns, 0, sizeof(columns));
+    head = 0;
+  }
+
+  /**
+   * @brief Adds a column, replacing the oldest one.
+   * @param pages The packed column, WATERFALL_PAGES bytes.
+   */
+  void push(const unsigned char *pages) {
+    memcpy(columns[head], pages, WATERFALL_PAGES);
+    head = (head + 1) % WATERFALL_COLUMNS;
+  }
+
+  /**
+   * @brief Gets a column by age.
+   * @param age 0 for the newest column.
+   * @return The packed column.
+   */
+  const unsigned char *column(unsigned short age) const {
+    return columns[(head + WATERFALL_COLUMNS - 1 - (age % WATERFALL_COLUMNS)) % WATERFALL_COLUMNS];
+  }
+
+  /**
+   * @brief Copies the waterfall into a framebuffer, newest column on the left.
+   *
+   * @param frame SSD1306 framebuffer (DISPLAY_WIDTH bytes per page).
+   * @param xNewest Screen column of the newest column.
+   * @param xOldest Screen column of the oldest column shown, >= xNewest.
+   */
+  void blit(unsigned char *frame, short xNewest, short xOldest) const {
+    for (short x = xNewest; x <= xOldest; x++) {
+      const unsigned char *src = column(x - xNewest);
+      for (unsigned char page = 0; page < WATERFALL_PAGES; page++) {
+        frame[page * DISPLAY_WIDTH + x] = src[page];
+      }
+    }
+  }
+};
+
+// ---------- Function Prototypes --------------
+/**
+ * @brief Quantizes a spectrum to a packed 1-bit column.
+ *
+ * @details The bottom row shows firstBin and each row up shows the next bin. A pixel is
+ * lit if the amplitude of its bin reaches the threshold.
+ *
+ * @param data The spectrum (FFT output).
+ * @param firstBin Bin of the bottom row.
+ * @param threshold Minimum amplitude of a lit pixel.
+ * @param pages Output column, WATERFALL_PAGES bytes.
+ */
+void quantizeColumn(const float _Complex *data, short firstBin, int threshold, unsigned char *pages);
+
+// ---------- Code --------------
+void quantizeColumn(const float _Complex *data, short firstBin, int threshold, unsigned char *pages) {
+  for (unsigned char page = 0; page < WATERFALL_PAGES; page++) {
+    unsigned char bits = 0;
+    for (unsigned char bit = 0; bit < 8; bit++) {
+      short y = page * 8 + bit;
+      int amplitude = abs((int)creal(data[firstBin + (DISPLAY_HEIGHT - 1 - y)]));
+      bits |= (amplitude >= threshold) << bit;
+    }
+    pages[page] = bits;
+  }
+}